@@ -0,0 +1,466 @@
+// Measure the throughput of libtext::read.
+//
+// For each type the input is generated in several shapes: narrow lines of 4
+// fields with a single character separator and with a multi character
+// separator, narrow lines with 2 of 4 fields skipped with 0 and wide lines of
+// 200 fields. Each shape is read by libtext::read and by the baselines:
+// sscanf, std::istringstream and std::from_chars. Wide lines are also read to
+// a std::vector by one libtext::read.
+// For each combination the report shows nanoseconds per field, gigabytes of
+// input per second and allocations per line.
+//
+// Usage: bench [seconds per combination]
+#include <libtext.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <new>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if defined __has_include && __has_include(<charconv>) && __cplusplus >= 201703L
+#include <charconv>
+#define have_from_chars 1
+#endif
+
+// The number of allocations made by operator new.
+static size_t nallocs = 0;
+
+void* operator new(size_t n)
+{
+    ++nallocs;
+    void* p = malloc(n ? n : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
+
+// The sum of the values read. Printed to keep the compiler from discarding
+// the reads.
+static uint64_t checksum = 0;
+
+static void consume(uint8_t x) { checksum += x; }
+static void consume(uint16_t x) { checksum += x; }
+static void consume(uint32_t x) { checksum += x; }
+static void consume(uint64_t x) { checksum += x; }
+static void consume(float x) { checksum += (uint64_t) x; }
+static void consume(double x) { checksum += (uint64_t) x; }
+static void consume(long double x) { checksum += (uint64_t) x; }
+static void consume(const std::string& x) { checksum += x.size(); }
+#ifdef have_string_view
+static void consume(std::string_view x) { checksum += x.size(); }
+#endif
+
+// The text of field 'k' of type T.
+template <class T>
+static std::string field(size_t k)
+{
+    return std::to_string((T) (k * 2654435761u));
+}
+
+template <>
+std::string field<float>(size_t k)
+{
+    return std::to_string((k % 100000) / 8.0);
+}
+
+template <>
+std::string field<double>(size_t k)
+{
+    return std::to_string((k % 100000) / 8.0);
+}
+
+template <>
+std::string field<long double>(size_t k)
+{
+    return std::to_string((k % 100000) / 8.0);
+}
+
+template <>
+std::string field<std::string>(size_t k)
+{
+    return "field" + std::to_string(k % 1000);
+}
+
+#ifdef have_string_view
+template <>
+std::string field<std::string_view>(size_t k)
+{
+    return field<std::string>(k);
+}
+#endif
+
+// The shape of input.
+struct shape {
+    const char* name;
+    const char* sep;
+    size_t nfields; // The number of fields per line.
+    int skip; // Set to skip fields 2 and 3 of each line with 0.
+};
+
+static const shape shapes[] = {
+    {"4 fields, \":\"", ":", 4, 0},
+    {"4 fields, \", \"", ", ", 4, 0},
+    {"4 fields, 2 skipped", ":", 4, 1},
+    {"200 fields, \":\"", ":", 200, 0},
+};
+
+// The input of one shape.
+struct corpus {
+    std::string text;
+    size_t nlines;
+    size_t nfields; // The total number of fields.
+};
+
+// Generate about 'len' bytes of lines of fields of type T.
+template <class T>
+static corpus generate(const shape& sh, size_t len)
+{
+    corpus c;
+    c.nlines = c.nfields = 0;
+    for (size_t k = 0; c.text.size() < len; ++c.nlines) {
+        for (size_t f = 0; f < sh.nfields; ++f, ++k, ++c.nfields) {
+            if (f)
+                c.text += sh.sep;
+            c.text += field<T>(k);
+        }
+        c.text += '\n';
+    }
+    return c;
+}
+
+template <class T>
+static size_t read_libtext(const corpus& c, const shape& sh)
+{
+    const char* s = c.text.c_str();
+    T a, b, x, y;
+    size_t n = 0;
+    if (sh.nfields == 4 && sh.skip)
+        for (; *s; s = libtext::nextline(s), ++n) {
+            s = libtext::read(s, sh.sep, &a, 0, 0, &b);
+            assert(s);
+            consume(a), consume(b);
+        }
+    else if (sh.nfields == 4)
+        for (; *s; s = libtext::nextline(s), ++n) {
+            s = libtext::read(s, sh.sep, &a, &b, &x, &y);
+            assert(s);
+            consume(a), consume(b), consume(x), consume(y);
+        }
+    else
+        for (; *s; s = libtext::nextline(s), ++n)
+            for (size_t f = 0; f < sh.nfields; ++f) {
+                s = libtext::read(s, sh.sep, &a);
+                assert(s);
+                consume(a);
+            }
+    return n;
+}
+
+// Read each wide line to a std::vector at once.
+template <class T>
+static size_t read_libtext_vector(const corpus& c, const shape& sh)
+{
+    static std::vector<T> v;
+    const char* s = c.text.c_str();
+    size_t n = 0;
+    for (; *s; s = libtext::nextline(s), ++n) {
+        s = libtext::read(s, sh.sep, &v);
+        assert(s);
+        for (size_t k = 0; k < v.size(); ++k)
+            consume(v[k]);
+    }
+    return n;
+}
+
+// The sscanf conversion of type T.
+template <class T> static const char* conversion();
+template <> const char* conversion<uint8_t>() { return "%" SCNu8 "%n"; }
+template <> const char* conversion<uint16_t>() { return "%" SCNu16 "%n"; }
+template <> const char* conversion<uint32_t>() { return "%" SCNu32 "%n"; }
+template <> const char* conversion<uint64_t>() { return "%" SCNu64 "%n"; }
+template <> const char* conversion<float>() { return "%f%n"; }
+template <> const char* conversion<double>() { return "%lf%n"; }
+template <> const char* conversion<long double>() { return "%Lf%n"; }
+
+template <class T>
+static const char* scan(const char* s, const char* sep, T* result)
+{
+    int n = 0;
+    if (sscanf(s, conversion<T>(), result, &n) != 1)
+        return 0;
+    (void) sep;
+    return s + n;
+}
+
+static const char* scan(const char* s, const char* sep, std::string* result)
+{
+    // A field ends at the first character of the separator.
+    char fmt[] = "%255[^?\n]%n";
+    char buf[256];
+    int n = 0;
+    *strchr(fmt, '?') = *sep;
+    if (sscanf(s, fmt, buf, &n) != 1)
+        return 0;
+    result->assign(buf, n);
+    return s + n;
+}
+
+#ifdef have_string_view
+static const char* scan(const char* s, const char* sep,
+                                                    std::string_view* result)
+{
+    char fmt[] = "%*[^?\n]%n";
+    int n = 0;
+    *strchr(fmt, '?') = *sep;
+    sscanf(s, fmt, &n);
+    if (!n)
+        return 0;
+    *result = std::string_view(s, n);
+    return s + n;
+}
+#endif
+
+// sscanf takes the length of its input on each call. Each line is copied to
+// 'line' to have sscanf take the length of the line, rather than the length
+// of the whole input.
+template <class T>
+static size_t read_sscanf(const corpus& c, const shape& sh)
+{
+    static std::vector<char> line;
+    const char* s = c.text.c_str();
+    const size_t seplen = strlen(sh.sep);
+    T v;
+    size_t n = 0;
+    for (; *s; s = libtext::nextline(s), ++n) {
+        const size_t len = strcspn(s, "\n");
+        line.resize(len + 1);
+        memcpy(&line[0], s, len);
+        line[len] = '\0';
+        const char* p = &line[0];
+        for (size_t f = 0; f < sh.nfields; ++f) {
+            if (f)
+                p += seplen;
+            p = scan(p, sh.sep, &v);
+            assert(p);
+            if (!sh.skip || f == 0 || f == 3)
+                consume(v);
+        }
+    }
+    return n;
+}
+
+// Extract one field of type T from 'is'.
+template <class T>
+static void extract(std::istream& is, const char*, T* result)
+{
+    is >> *result;
+}
+
+static void extract(std::istream& is, const char*, uint8_t* result)
+{
+    unsigned v;
+    is >> v;
+    *result = (uint8_t) v;
+}
+
+static void extract(std::istream& is, const char* sep, std::string* result)
+{
+    std::getline(is, *result, *sep);
+    if (!is.eof())
+        is.unget();
+}
+
+#ifdef have_string_view
+// std::istream cannot produce a view. Read into a string and view the string.
+static void extract(std::istream& is, const char* sep,
+                                                    std::string_view* result)
+{
+    static std::string buf;
+    extract(is, sep, &buf);
+    *result = buf;
+}
+#endif
+
+template <class T>
+static size_t read_istringstream(const corpus& c, const shape& sh)
+{
+    const char* s = c.text.c_str();
+    const size_t seplen = strlen(sh.sep);
+    T v;
+    size_t n = 0;
+    for (; *s; s = libtext::nextline(s), ++n) {
+        std::istringstream is(libtext::oneline(s));
+        for (size_t f = 0; f < sh.nfields; ++f) {
+            if (f)
+                is.ignore(seplen);
+            extract(is, sh.sep, &v);
+            assert(is);
+            if (!sh.skip || f == 0 || f == 3)
+                consume(v);
+        }
+    }
+    return n;
+}
+
+#ifdef have_from_chars
+template <class T>
+static size_t read_from_chars(const corpus& c, const shape& sh)
+{
+    const char* s = c.text.c_str();
+    const char* end = s + c.text.size();
+    const size_t seplen = strlen(sh.sep);
+    T v;
+    size_t n = 0;
+    for (; s < end; ++s, ++n)
+        for (size_t f = 0; f < sh.nfields; ++f) {
+            if (f)
+                s += seplen;
+            const std::from_chars_result r = std::from_chars(s, end, v);
+            assert(r.ec == std::errc());
+            s = r.ptr;
+            if (!sh.skip || f == 0 || f == 3)
+                consume(v);
+        }
+    return n;
+}
+#endif
+
+// Whether std::from_chars reads type T.
+template <class T>
+struct from_chars_type {
+#if defined have_from_chars && defined __cpp_lib_to_chars
+    static const bool value = true;
+#elif defined have_from_chars
+    static const bool value = std::is_integral<T>::value;
+#else
+    static const bool value = false;
+#endif
+};
+
+template <>
+struct from_chars_type<std::string> {
+    static const bool value = false;
+};
+
+#ifdef have_string_view
+template <>
+struct from_chars_type<std::string_view> {
+    static const bool value = false;
+};
+#endif
+
+static double seconds = 0.1;
+
+// Run 'method' on 'c' repeatedly for at least 'seconds' and print the result.
+template <class F>
+static void run(const char* type, const shape& sh, const char* method,
+                                                    const corpus& c, F method_)
+{
+    typedef std::chrono::steady_clock clock;
+    size_t runs = 0, allocs = nallocs;
+    double elapsed = 0;
+    while (elapsed < seconds) {
+        const clock::time_point beg = clock::now();
+        const size_t nlines = method_(c, sh);
+        elapsed += std::chrono::duration<double>(clock::now() - beg).count();
+        assert(nlines == c.nlines);
+        (void) nlines;
+        ++runs;
+    }
+    allocs = nallocs - allocs;
+    std::cout
+        << std::left << std::setw(12) << type << std::setw(22) << sh.name
+        << std::setw(20) << method << std::right << std::fixed
+        << std::setprecision(2)
+        << std::setw(10) << elapsed * 1e9 / (runs * c.nfields)
+        << std::setw(8) << runs * c.text.size() / elapsed / 1e9
+        << std::setw(13) << (double) allocs / (runs * c.nlines)
+        << std::endl;
+}
+
+#ifdef have_from_chars
+template <class T>
+static void run_from_chars(const char* type, const shape& sh, const corpus& c,
+                                                                std::true_type)
+{
+    run(type, sh, "std::from_chars", c, read_from_chars<T>);
+}
+
+template <class T>
+static void run_from_chars(const char*, const shape&, const corpus&,
+                                                                std::false_type)
+{
+}
+#endif
+
+template <class T>
+static void bench(const char* type)
+{
+    for (size_t k = 0; k < sizeof shapes / sizeof *shapes; ++k) {
+        const shape& sh = shapes[k];
+        const corpus c = generate<T>(sh, 1 << 20);
+        run(type, sh, "libtext::read", c, read_libtext<T>);
+        if (sh.nfields > 4)
+            run(type, sh, "libtext::read vector", c, read_libtext_vector<T>);
+        run(type, sh, "sscanf", c, read_sscanf<T>);
+        run(type, sh, "std::istringstream", c, read_istringstream<T>);
+#ifdef have_from_chars
+        run_from_chars<T>(type, sh, c,
+                    std::integral_constant<bool, from_chars_type<T>::value>());
+#endif
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 2 || (argc == 2 && (seconds = atof(argv[1])) <= 0)) {
+        std::cerr << "usage: " << argv[0] << " [seconds]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout
+        << std::left << std::setw(12) << "type" << std::setw(22) << "shape"
+        << std::setw(20) << "method" << std::right << std::setw(10)
+        << "ns/field" << std::setw(8) << "GB/s" << std::setw(13)
+        << "allocs/line" << std::endl;
+    bench<uint8_t>("uint8_t");
+    bench<uint16_t>("uint16_t");
+    bench<uint32_t>("uint32_t");
+    bench<uint64_t>("uint64_t");
+    bench<float>("float");
+    bench<double>("double");
+    bench<long double>("long double");
+    bench<std::string>("std::string");
+#ifdef have_string_view
+    bench<std::string_view>("string_view");
+#endif
+    std::cerr << "checksum = " << checksum << std::endl;
+    return 0;
+}
+
+/*
+ * Copyright (c) 2017 Dmitry Goncharov
+ *
+ * Distributed under the BSD License.
+ * (See accompanying file COPYING).
+ */
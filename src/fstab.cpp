@@ -20,10 +20,14 @@ typedef std::string string;
 #endif
 
 struct fsent {
-    string fs_spec;
-    string fs_file;
+    // The device and the mount point. A space, a tab or a backslash in either
+    // is written as \040, \011 or \134, which read decodes.
+    std::string fs_spec;
+    std::string fs_file;
     string fs_type;
-    string fs_opts;
+    // The mount options, e.g. rw,noatime,errors=remount-ro, as pairs of a
+    // name and a value.
+    std::vector<std::pair<string, string> > fs_opts;
     int fs_freq;
     int fs_passno;
 };
@@ -64,8 +68,10 @@ int main(int argc, char* argv[])
         v.resize(v.size() + 1);
         fsent& m = v.back();
         s = input;
-        input = libtext::read(input, " ", &m.fs_spec, &m.fs_file,
-                        &m.fs_type, &m.fs_opts, &m.fs_freq, &m.fs_passno);
+        input = libtext::read(input, " ", libtext::unescape(&m.fs_spec),
+                        libtext::unescape(&m.fs_file),
+                        &m.fs_type, libtext::list(&m.fs_opts, ","),
+                        &m.fs_freq, &m.fs_passno);
         if (!input) {
             cerr
                 << "malformed line /etc/fstab:" << lineno << " "
@@ -73,11 +79,19 @@ int main(int argc, char* argv[])
             return EXIT_FAILURE;
         }
     }
-    for (size_t k = 0, len = v.size(); k < len; ++k)
+    for (size_t k = 0, len = v.size(); k < len; ++k) {
         std::cout
             << v[k].fs_spec << " " << v[k].fs_file << " "
-            << v[k].fs_type << " " << v[k].fs_opts << " "
-            << v[k].fs_freq << " " << v[k].fs_passno
+            << v[k].fs_type << " ";
+        for (size_t j = 0; j < v[k].fs_opts.size(); ++j) {
+            const std::pair<string, string>& opt = v[k].fs_opts[j];
+            std::cout << (j ? "," : "") << opt.first;
+            if (!opt.second.empty())
+                std::cout << "=" << opt.second;
+        }
+        std::cout
+            << " " << v[k].fs_freq << " " << v[k].fs_passno
             << std::endl;
+    }
     return 0;
 }
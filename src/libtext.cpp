@@ -1,10 +1,148 @@
 #include <libtext.h>
+#include "probe.h"
 #include <limits>
+#include <algorithm>
+#include <type_traits>
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#ifdef LIBTEXT_STATS
+#include <atomic>
+#include <mutex>
+#include <set>
+#endif
+
+typedef libtext::statistics stats_t;
+
+#ifdef LIBTEXT_STATS
+namespace {
+// The counters of one thread.
+// Only the owning thread modifies the counters. stats() reads the counters of
+// all threads. Relaxed atomic loads and stores let stats() read the counters
+// without a data race and without the cost of a locked increment.
+struct counters {
+    std::atomic<uint64_t> bytes_scanned;
+    std::atomic<uint64_t> fields[stats_t::ntypes];
+    std::atomic<uint64_t> failures[stats_t::nreasons];
+    std::atomic<uint64_t> bytes_copied;
+
+    counters();
+    ~counters();
+};
+
+// The counters of all running threads and the sum of the counters of the
+// threads which have exited.
+struct registry {
+    std::mutex mutex;
+    std::set<const counters*> live;
+    stats_t retired;
+};
+
+// The registry is constructed on first use to let the threads, which read
+// during static initialization, register.
+registry& reg()
+{
+    static registry r;
+    return r;
+}
+
+thread_local counters tls;
+
+void add(std::atomic<uint64_t>& c, uint64_t n)
+{
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+uint64_t get(const std::atomic<uint64_t>& c)
+{
+    return c.load(std::memory_order_relaxed);
+}
+
+// Add the counters of 'c' to 'result'.
+void sum(stats_t* result, const counters& c)
+{
+    result->bytes_scanned += get(c.bytes_scanned);
+    for (int k = 0; k < stats_t::ntypes; ++k)
+        result->fields[k] += get(c.fields[k]);
+    for (int k = 0; k < stats_t::nreasons; ++k)
+        result->failures[k] += get(c.failures[k]);
+    result->bytes_copied += get(c.bytes_copied);
+}
+
+counters::counters()
+    : bytes_scanned(0), fields(), failures(), bytes_copied(0)
+{
+    registry& r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.insert(this);
+}
+
+counters::~counters()
+{
+    registry& r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    sum(&r.retired, *this);
+    r.live.erase(this);
+}
+} // namespace
+#endif
+
+// Count a successful read of a field of type 'type' from 'input' to 'end'.
+// A negative 'type' counts the bytes of a skipped field.
+// Return 'end'.
+static const char* counted(int type, const char* input, const char* end)
+{
+#ifdef LIBTEXT_STATS
+    if (end) {
+        add(tls.bytes_scanned, end - input);
+        if (type >= 0)
+            add(tls.fields[type], 1);
+    }
+#else
+    (void) type, (void) input;
+#endif
+    return end;
+}
+
+#ifdef LIBTEXT_PROBES
+// The reason of the last failure of this thread for probe read_failure.
+static thread_local int last_failure;
+#endif
+
+// Count a failure of 'reason'.
+// Return 0.
+static const char* fail(int reason)
+{
+#ifdef LIBTEXT_STATS
+    add(tls.failures[reason], 1);
+#endif
+#ifdef LIBTEXT_PROBES
+    last_failure = reason;
+#endif
+    (void) reason;
+    return 0;
+}
+
+// Count 'n' bytes copied to a std::string.
+static void copied(const std::string*, size_t n)
+{
+#ifdef LIBTEXT_STATS
+    add(tls.bytes_copied, n);
+#else
+    (void) n;
+#endif
+}
+
+#ifdef have_string_view
+// A std::string_view refers to the input and copies nothing.
+static void copied(const std::string_view*, size_t)
+{
+}
+#endif
 
 // Return 1 if 'input' points at the end of the line or at the end of the string.
 // Return 0 otherwise.
@@ -18,6 +156,17 @@ static int ws(const char* input)
     return ' ' == *input || '\t' == *input;
 }
 
+// Return the address of the first character in 'input', which is neither a
+// space nor a tab.
+// An inline loop is faster than strspn on the short runs of space between
+// fields.
+static const char* skipws(const char* input)
+{
+    while (ws(input))
+        ++input;
+    return input;
+}
+
 // Return 1 if the first character of x is the same as the first character of
 // y. Consider a space to be equal to a tab.
 static int same(const char* x, const char* y)
@@ -48,24 +197,78 @@ static const char* skipsep(const char* input, const char* sep)
 // space followed by eol then return 0.
 // Otherwise return the address of the first character after the first
 // separator.
-static const char* next(const char* input, const char* sep)
+// If 'e' is not null, then the field which follows the separator may be empty.
+// If the separator is followed by eol, then record the address of eol in the
+// state of this call of read to let the caller tell the empty last field from
+// a missing field.
+static const char* next(const char* input, const char* sep,
+                        const libtext::empty_fields* e)
 {
     if (!ws(sep))
-        input += strspn(input, " \t");
+        input = skipws(input);
     if (eol(input))
         // Return 'input' to let the caller detect a possible malformed input
         // should the user expect more fields.
         return input;
     input = skipsep(input, sep);
     if (!input)
-        return 0; // Expected separator is not found.
-    input += strspn(input, " \t");
+        return fail(stats_t::missing_separator);
+    input = skipws(input);
     if (ws(sep))
         return input;
+    if (e) {
+        if (eol(input) && e->trailing)
+            *e->trailing = input;
+        return input;
+    }
     if (skipsep(input, sep))
-        return 0; // Multiple consecutive separators
+        return fail(stats_t::consecutive_separators);
+    if (eol(input))
+        // String ends with a separator other than ws.
+        return fail(stats_t::trailing_separator);
+    return input;
+}
+
+// Count the failure to convert the field at 'input'.
+// The field is missing when 'input' points at the end of the line or at a
+// separator.
+// Return 0.
+static const char* unconverted(const char* input, const char* sep)
+{
+    if (eol(input) || skipsep(input, sep))
+        return fail(stats_t::missing_field);
+    return fail(stats_t::invalid_value);
+}
+
+// Count the failure of a conversion, which has set errno.
+// Return 0.
+static const char* converror()
+{
+    return fail(errno == ERANGE ? stats_t::overflow : stats_t::invalid_value);
+}
+
+// Return 1 if 'e' is not null and the field at 'input' is empty.
+// A field is empty if 'input' points at a separator or at eol, which follows
+// a separator. A space or tab separator separates no empty fields.
+static int empty(const char* input, const char* sep,
+                 const libtext::empty_fields* e)
+{
+    if (!e || ws(sep))
+        return 0;
     if (eol(input))
-        return 0; // String ends with a separator other than ws.
+        return e->trailing && input == *e->trailing;
+    return skipsep(input, sep) != 0;
+}
+
+// Skip the empty field at 'input'.
+// Return the address of the next field or of eol.
+static const char* skipempty(const char* input, const char* sep,
+                             const libtext::empty_fields* e)
+{
+    if (!eol(input))
+        return next(input, sep, e);
+    // The last field is empty. Another field at eol is missing.
+    *e->trailing = 0;
     return input;
 }
 
@@ -80,65 +283,81 @@ static const char* nextsep(const char* input, const char* sep)
 }
 
 template <class T>
-static const char* readll(const char* input, const char* sep, T* result)
+static const char* readll(const char* input, const char* sep, T* result,
+                          const libtext::empty_fields* e)
 {
     // strtoull skips leading space, \t, \n, \v, \f, \r.
     // Detect malformed input by skipping " \t" and checking if the following
     // char is a space as determined by isspace.
-    input += strspn(input, " \t");
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
     if (isspace((unsigned char) *input))
-        return 0;
+        return unconverted(input, sep);
     char* r;
     errno = 0;
     const long long v = strtoll(input, &r, 0);
-    if (errno || r == input)
-        return 0;
+    if (errno)
+        return converror();
+    if (r == input)
+        return unconverted(input, sep);
     if (std::numeric_limits<T>::max() < v)
-        return 0; // Overflow.
+        return fail(stats_t::overflow);
     if (std::numeric_limits<T>::min() > v)
-        return 0; // Underflow.
+        return fail(stats_t::overflow); // Underflow.
     if (result) {
         *result = (T) v;
     }
-    return next(r, sep);
+    return next(r, sep, e);
 }
 
 template <class T>
-static const char* readull(const char* input, const char* sep, T* result)
+static const char* readull(const char* input, const char* sep, T* result,
+                           const libtext::empty_fields* e)
 {
     // strtoull skips leading space, \t, \n, \v, \f, \r.
     // Detect malformed input by skipping " \t" and checking if the following
     // char is a space as determined by isspace.
-    input += strspn(input, " \t");
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
     if (isspace((unsigned char) *input))
-        return 0;
+        return unconverted(input, sep);
     char* r;
     errno = 0;
     const unsigned long long v = strtoull(input, &r, 0);
-    if (errno || r == input)
-        return 0;
+    if (errno)
+        return converror();
+    if (r == input)
+        return unconverted(input, sep);
     const unsigned long long ullmax =
         std::numeric_limits<unsigned long long>::max();
     const T tmax = std::numeric_limits<T>::max();
     const int neg = *input == '-';
     if (!neg && tmax < v)
-        return 0; // Overflow.
+        return fail(stats_t::overflow);
     if (neg && v && v <= ullmax - tmax)
-        return 0; // Underflow.
+        return fail(stats_t::overflow); // Underflow.
     if (result)
         *result = (T) v;
-    return next(r, sep);
+    return next(r, sep, e);
 }
 
 template <class R>
-static const char* reads(const char* input, const char* sep, R* result)
+static const char* reads(const char* input, const char* sep, R* result,
+                         const libtext::empty_fields* e)
 {
     // Skip white space.
-    input += strspn(input, " \t");
+    input = skipws(input);
+    if (empty(input, sep, e)) {
+        if (result)
+            R().swap(*result);
+        return skipempty(input, sep, e);
+    }
     // Read a word.
     const char* s = nextsep(input, sep);
     if (s == input)
-        return 0; // Have not read anything.
+        return fail(stats_t::missing_field); // Have not read anything.
     // Have read something.
     assert(s > input);
     assert(!ws(input));
@@ -150,134 +369,2231 @@ static const char* reads(const char* input, const char* sep, R* result)
         assert(!ws(p));
         R tmp(input, p-input+1);
         result->swap(tmp);
+        copied(result, p-input+1);
     }
-    return next(s, sep);
+    return next(s, sep, e);
 }
 
-namespace libtext
+// Read a field of type 'type' with 'reader'.
+// Fire probe read_entry with the input and the type of the field and, if
+// the read fails, probe read_failure with the input, the type and the reason.
+// The types and the reasons are those of libtext::statistics. The type of a
+// skipped field is -1.
+template <class T>
+static const char* field(int type, const char* input, const char* sep,
+                         T* result,
+                         const char* (*reader)(const char*, const char*, T*,
+                                               const libtext::empty_fields*),
+                         const libtext::empty_fields* e = 0)
 {
-const char* read(const char* input, const char* sep, std::string* result)
+    LIBTEXT_PROBE2(libtext, read_entry, input, type);
+    const char* s = reader(input, sep, result, e);
+#ifdef LIBTEXT_PROBES
+    if (!s)
+        LIBTEXT_PROBE3(libtext, read_failure, input, type, last_failure);
+#endif
+    return counted(type, input, s);
+}
+
+// Return the address of the first character which follows 'sep', if 'sep'
+// is at 'input' and ends no later than 'end'. Return 0 otherwise.
+static const char* sepuntil(const char* input, const char* end,
+                            const char* sep)
+{
+    const char* s = skipsep(input, sep);
+    return s && s <= end ? s : 0;
+}
+
+// Append the item [input, end) to 'result'.
+template <class V>
+static int item(std::vector<V>* result, const char* input, const char* end,
+                const char*)
+{
+    result->push_back(V(input, end - input));
+    return 1;
+}
+
+// Split the item [input, end) at the first 'kvsep' to a key and a value and
+// append the pair to 'result'. Return 0 if the key is empty.
+template <class V>
+static int item(std::vector<std::pair<V, V> >* result, const char* input,
+                const char* end, const char* kvsep)
+{
+    const char* k = input;
+    while (k < end && !sepuntil(k, end, kvsep))
+        ++k;
+    if (k == input)
+        return 0;
+    const char* v = k < end ? sepuntil(k, end, kvsep) : end;
+    result->push_back(std::pair<V, V>(V(input, k - input), V(v, end - v)));
+    return 1;
+}
+
+// Read a field and split it to the items of a list in the same pass.
+// Skip the space around each item.
+template <class V>
+static const char* readlist(const char* input, const char* sep,
+                            libtext::list_field<V> result)
+{
+    input = skipws(input);
+    const char* s = nextsep(input, sep);
+    if (s == input)
+        return fail(stats_t::missing_field);
+    const char* end = s;
+    while (ws(end - 1))
+        --end;
+    result.result->clear();
+    for (const char* b = input;;) {
+        const char* p = b;
+        while (p < end && !sepuntil(p, end, result.sep))
+            ++p;
+        const char* e = p;
+        while (e > b && ws(e - 1))
+            --e;
+        if (e == b)
+            return fail(b == input ? stats_t::missing_field
+                                   : stats_t::consecutive_separators);
+        if (!item(result.result, b, e, result.kvsep))
+            return fail(stats_t::invalid_value); // An empty key.
+        if (p == end)
+            break;
+        b = skipws(sepuntil(p, end, result.sep));
+        if (b >= end)
+            return fail(stats_t::trailing_separator);
+    }
+    return next(s, sep, 0);
+}
+
+// Decode the escapes of [input, end) and append the result to 'out'.
+// Return 0 if an escape is malformed. Return 1 otherwise.
+static int decode(const char* input, const char* end, std::string* out)
 {
-    return reads(input, sep, result);
+    while (input < end) {
+        const char* b = static_cast<const char*>(memchr(input, '\\',
+                                                        end - input));
+        if (!b)
+            b = end;
+        out->append(input, b);
+        if (b == end)
+            break;
+        if (++b == end)
+            return 0; // A trailing backslash.
+        if (*b >= '0' && *b <= '7') {
+            unsigned v = 0;
+            for (input = b; input < b + 3 && input < end; ++input) {
+                if (*input < '0' || *input > '7')
+                    break;
+                v = v * 8 + *input - '0';
+            }
+            if (v > 0377)
+                return 0;
+            out->push_back(char(v));
+            continue;
+        }
+        switch (*b) {
+        case '\\': case '\'': case '"': out->push_back(*b); break;
+        case 'a': out->push_back('\a'); break;
+        case 'b': out->push_back('\b'); break;
+        case 'f': out->push_back('\f'); break;
+        case 'n': out->push_back('\n'); break;
+        case 'r': out->push_back('\r'); break;
+        case 't': out->push_back('\t'); break;
+        case 'v': out->push_back('\v'); break;
+        default: return 0;
+        }
+        input = b + 1;
+    }
+    return 1;
+}
+
+// Store the decoded field to the std::string.
+static void unescaped(libtext::unescape_field<std::string>* result,
+                      std::string* decoded)
+{
+    result->result->swap(*decoded);
+    copied(result->result, result->result->size());
 }
 
 #ifdef have_string_view
-const char* read(const char* input, const char* sep, std::string_view* result)
+// Refer the std::string_view to the decoded field in '*buf'.
+static void unescaped(libtext::unescape_field<std::string_view>* result,
+                      std::string* decoded)
 {
-    return reads(input, sep, result);
+    result->buf->swap(*decoded);
+    *result->result = *result->buf;
+    copied(result->buf, result->buf->size());
 }
 #endif
 
-const char* read(const char* input, const char* sep, uint8_t* result)
+// Read a string field and decode its escapes.
+// The same scan, which finds the end of the field, finds the first backslash.
+// A field without backslash is copied as is, i.e. a std::string_view refers
+// to the input.
+template <class S>
+static const char* readunescaped(const char* input, const char* sep,
+                                 libtext::unescape_field<S>* result,
+                                 const libtext::empty_fields* e)
 {
-    return readull(input, sep, result);
+    input = skipws(input);
+    if (empty(input, sep, e)) {
+        S().swap(*result->result);
+        return skipempty(input, sep, e);
+    }
+    const char* bs = 0;
+    const char* s = input;
+    for (; !eol(s) && !skipsep(s, sep); ++s)
+        if ('\\' == *s && !bs)
+            bs = s;
+    if (s == input)
+        return fail(stats_t::missing_field);
+    const char* end = s;
+    while (ws(end - 1))
+        --end;
+    if (!bs) {
+        S tmp(input, end - input);
+        result->result->swap(tmp);
+        copied(result->result, end - input);
+        return next(s, sep, e);
+    }
+    std::string decoded(input, bs);
+    if (!decode(bs, end, &decoded))
+        return fail(stats_t::invalid_value);
+    unescaped(result, &decoded);
+    return next(s, sep, e);
 }
 
-const char* read(const char* input, const char* sep, uint16_t* result)
+// Read a field of a type of the user with the converter of the type.
+static const char* readcustom(const char* input, const char* sep,
+                              libtext::detail::custom_field* result,
+                              const libtext::empty_fields* e)
 {
-    return readull(input, sep, result);
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* s = nextsep(input, sep);
+    if (s == input)
+        return fail(stats_t::missing_field);
+    const char* end = s;
+    while (ws(end - 1))
+        --end;
+    if (!result->convert(input, end, result->result))
+        return fail(stats_t::invalid_value);
+    return next(s, sep, e);
 }
 
-const char* read(const char* input, const char* sep, uint32_t* result)
+// Read a name of a vocabulary or a list of names.
+static const char* readsymbol(const char* input, const char* sep,
+                              libtext::detail::symbol_field* result,
+                              const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* s = nextsep(input, sep);
+    if (s == input)
+        return fail(stats_t::missing_field);
+    const char* end = s;
+    while (ws(end - 1))
+        --end;
+    if (!result->listsep) {
+        const int64_t* v = result->names->find(input, end - input);
+        if (!v)
+            return fail(stats_t::invalid_value);
+        *result->value = *v;
+        *result->converted = 1;
+        return next(s, sep, e);
+    }
+    int64_t mask = 0;
+    size_t unknown = 0;
+    for (const char* b = input;;) {
+        const char* p = b;
+        while (p < end && !sepuntil(p, end, result->listsep))
+            ++p;
+        const char* ie = p;
+        while (ie > b && ws(ie - 1))
+            --ie;
+        if (ie == b)
+            return fail(b == input ? stats_t::missing_field
+                                   : stats_t::consecutive_separators);
+        if (const int64_t* v = result->names->find(b, ie - b))
+            mask |= *v;
+        else if (result->unknown)
+            ++unknown;
+        else
+            return fail(stats_t::invalid_value);
+        if (p == end)
+            break;
+        b = skipws(sepuntil(p, end, result->listsep));
+        if (b >= end)
+            return fail(stats_t::trailing_separator);
+    }
+    *result->value = mask;
+    *result->converted = 1;
+    if (result->unknown)
+        *result->unknown = unknown;
+    return next(s, sep, e);
+}
+
+// Hash the first 'len' characters of 'key' with FNV-1a, which starts from
+// 'seed'. The final multiplication and shift mix the last characters to the
+// low bits.
+static uint64_t keyhash(uint64_t seed, const char* key, size_t len)
 {
-    return readull(input, sep, result);
+    uint64_t h = seed;
+    for (size_t k = 0; k < len; ++k)
+        h = (h ^ (unsigned char) key[k]) * 0x100000001b3ull;
+    h *= 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 29);
 }
 
-const char* read(const char* input, const char* sep, uint64_t* result)
+// The bucket of hash 'h' among 2^bbits buckets.
+static size_t hashbucket(uint64_t h, unsigned bbits)
 {
-    return readull(input, sep, result);
+    return h >> (64 - bbits);
 }
 
-const char* read(const char* input, const char* sep, int8_t* result)
+// The slot of hash 'h' in a table of 2^bits slots, when the bucket of 'h' is
+// displaced by 'd'. The low half of 'h' is the first slot and the high half
+// is the step.
+static size_t hashslot(uint64_t h, uint32_t d, unsigned bits)
 {
-    return readll(input, sep, result);
+    const uint32_t first = (uint32_t) h, step = (uint32_t) (h >> 32) | 1;
+    return (first + d * step) & ((uint32_t(1) << bits) - 1);
 }
 
-const char* read(const char* input, const char* sep, int16_t* result)
+// Order buckets by decreasing number of keys.
+struct bigger {
+    explicit bigger(const std::vector<std::vector<size_t> >& b) : buckets(b)
+    {
+    }
+    bool operator()(size_t x, size_t y) const
+    {
+        return buckets[x].size() > buckets[y].size();
+    }
+    const std::vector<std::vector<size_t> >& buckets;
+};
+
+// Build a perfect hash table of 'keys' with hash and displace.
+// The keys are distributed to 2^bbits buckets, about 2 keys per bucket. Then,
+// starting from the largest bucket, find the least displacement of each
+// bucket, which places all keys of the bucket to free slots of 'table'.
+// The table has at least 2 slots per key, which lets most buckets have a small
+// displacement. If some bucket cannot be placed, try another seed.
+// Store to 'table' the index of each key at slot
+// hashslot(h, (*disp)[hashbucket(h, bbits)], bits), where
+// h = keyhash(seed, key).
+static void perfect_hash(const std::vector<std::string>& keys,
+                         std::vector<int>* table,
+                         std::vector<uint32_t>* disp, uint64_t* seed,
+                         unsigned* bits, unsigned* bbits)
 {
-    return readll(input, sep, result);
+    unsigned tb = 1, bb = 1;
+    while ((size_t(1) << tb) < 2 * keys.size())
+        ++tb;
+    while ((size_t(1) << bb) < keys.size() / 2)
+        ++bb;
+    const uint32_t maxdisp = uint32_t(16) << tb;
+    std::vector<uint64_t> hashes(keys.size());
+    std::vector<std::vector<size_t> > buckets;
+    std::vector<size_t> order(size_t(1) << bb);
+    for (uint64_t s = 0xcbf29ce484222325ull;; s += 0x9e3779b97f4a7c15ull) {
+        buckets.assign(size_t(1) << bb, std::vector<size_t>());
+        for (size_t k = 0; k < keys.size(); ++k) {
+            hashes[k] = keyhash(s, keys[k].data(), keys[k].size());
+            buckets[hashbucket(hashes[k], bb)].push_back(k);
+        }
+        for (size_t b = 0; b < order.size(); ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), bigger(buckets));
+        table->assign(size_t(1) << tb, -1);
+        disp->assign(size_t(1) << bb, 0);
+        size_t b = 0;
+        for (; b < order.size() && !buckets[order[b]].empty(); ++b) {
+            const std::vector<size_t>& bucket = buckets[order[b]];
+            uint32_t d = 0;
+            for (; d < maxdisp; ++d) {
+                size_t j = 0;
+                for (; j < bucket.size(); ++j) {
+                    int& slot = (*table)[hashslot(hashes[bucket[j]], d, tb)];
+                    if (slot >= 0)
+                        break; // Collision.
+                    slot = (int) bucket[j];
+                }
+                if (j == bucket.size())
+                    break;
+                while (j--) // Undo.
+                    (*table)[hashslot(hashes[bucket[j]], d, tb)] = -1;
+            }
+            if (d == maxdisp)
+                break;
+            (*disp)[order[b]] = d;
+        }
+        if (b == order.size() || buckets[order[b]].empty()) {
+            *seed = s;
+            *bits = tb;
+            *bbits = bb;
+            return;
+        }
+    }
 }
 
-const char* read(const char* input, const char* sep, int32_t* result)
+// Convert the 8 decimal digits at 'input' at once.
+static uint64_t parse8(const char* input)
 {
-    return readll(input, sep, result);
+    uint64_t v;
+    memcpy(&v, input, sizeof v);
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Combine the pairs of adjacent digits, then the pairs of 2 digit numbers
+    // and then the pairs of 4 digit numbers by multiplication.
+    v -= 0x3030303030303030ull;
+    v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffull;
+    v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffffull;
+    return (v * 10000 + (v >> 32)) & 0xffffffffull;
+#else
+    v = 0;
+    for (int k = 0; k < 8; ++k)
+        v = v * 10 + (input[k] - '0');
+    return v;
+#endif
 }
 
-const char* read(const char* input, const char* sep, int64_t* result)
+// Convert the decimal number at 'input' to '*v' and return the address of
+// the character which follows the number.
+// Return 0 if 'input' is not a decimal number of at most 19 digits, e.g. an
+// octal or a hexadecimal number, to let the caller fall back to strtoll.
+static const char* parsedec(const char* input, uint64_t* v)
+{
+    const char* p = input;
+    while (p - input < 20 && (unsigned) (*p - '0') < 10)
+        ++p;
+    size_t len = p - input;
+    if (len == 0 || len > 19 || (*input == '0' && len > 1))
+        return 0;
+    if (*input == '0' && (*p == 'x' || *p == 'X'))
+        return 0;
+    // The digits are scanned and 8 digits are converted at once.
+    uint64_t r = 0;
+    for (; len >= 8; len -= 8, input += 8)
+        r = r * 100000000 + parse8(input);
+    for (; len; --len, ++input)
+        r = r * 10 + (*input - '0');
+    *v = r;
+    return p;
+}
+
+// Fall back to readll for a signed type and to readull for an unsigned type.
+template <class T>
+static const char* readint(const char* input, const char* sep, T* result,
+                           const libtext::empty_fields* e, std::true_type)
 {
-    return readll(input, sep, result);
+    return readll(input, sep, result, e);
 }
 
 template <class T>
-static T str2f(const char* input, char** end);
+static const char* readint(const char* input, const char* sep, T* result,
+                           const libtext::empty_fields* e, std::false_type)
+{
+    return readull(input, sep, result, e);
+}
 
-template <>
-float str2f<float>(const char* input, char** end)
+// Same as readll and readull, but convert a decimal number without strtoll.
+// The numbers of the remaining fields of a line are usually decimal. Fall back
+// to readll or readull otherwise.
+template <class T>
+static const char* readdec(const char* input, const char* sep, T* result,
+                           const libtext::empty_fields* e)
 {
-    return strtof(input, end);
+    const bool is_signed = std::numeric_limits<T>::is_signed;
+    const char* p = skipws(input);
+    const int neg = *p == '-';
+    if (neg || *p == '+')
+        ++p;
+    uint64_t v;
+    const char* r = neg && !is_signed ? 0 : parsedec(p, &v);
+    if (!r)
+        return readint(input, sep, result, e,
+                       std::integral_constant<bool, is_signed>());
+    const uint64_t max = std::numeric_limits<T>::max();
+    if (v > max + neg)
+        return fail(stats_t::overflow);
+    if (result)
+        *result = neg ? (T) (-(long long) (v - 1) - 1) : (T) v;
+    return next(r, sep, e);
 }
 
-template <>
-double str2f<double>(const char* input, char** end)
+// Convert the 8 hexadecimal digits at 'input' at once.
+static uint64_t parse8hex(const char* input)
 {
-    return strtod(input, end);
+    uint64_t v;
+    memcpy(&v, input, sizeof v);
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // The low 4 bits of a digit are its value, if the digit is 0-9, or its
+    // value - 9, if the digit is a-f or A-F. Bit 6 is set only in a-f and A-F.
+    v = (v & 0x0f0f0f0f0f0f0f0full) + ((v >> 6) & 0x0101010101010101ull) * 9;
+    // Combine the digits like parse8 does.
+    v = (v * 16 + (v >> 8)) & 0x00ff00ff00ff00ffull;
+    v = (v * 256 + (v >> 16)) & 0x0000ffff0000ffffull;
+    return (v * 65536 + (v >> 32)) & 0xffffffffull;
+#else
+    v = 0;
+    for (int k = 0; k < 8; ++k)
+        v = v * 16 + (input[k] & 0xf) + (input[k] >> 6) * 9;
+    return v;
+#endif
+}
+
+// Return the value of 'c' as a digit of base 'Base'.
+// Return a number not less than 'Base' if 'c' is not a digit.
+template <int Base>
+static unsigned digit(char c)
+{
+    return (unsigned) (c - '0');
 }
 
 template <>
-long double str2f<long double>(const char* input, char** end)
+unsigned digit<16>(char c)
 {
-    return strtold(input, end);
+    const unsigned d = (unsigned) (c - '0');
+    if (d < 10)
+        return d;
+    const unsigned x = (unsigned) ((c | 0x20) - 'a');
+    return x < 6 ? x + 10 : 16;
 }
 
-template <class T>
-static const char* readfloat(const char* input, const char* sep, T* result)
+// Convert 'len' digits of base 'Base' at 'input', which fit 64 bits.
+// Decimal and hexadecimal digits are converted 8 at once.
+template <int Base>
+static uint64_t parsedigits(const char* input, size_t len)
 {
-    // strtoull skips leading space, \t, \n, \v, \f, \r.
-    // Detect malformed input by skipping " \t" and checking if the following
-    // char is a space as determined by isspace.
-    input += strspn(input, " \t");
-    if (isspace((unsigned char) *input))
+    uint64_t r = 0;
+    for (; Base == 10 && len >= 8; len -= 8, input += 8)
+        r = r * 100000000 + parse8(input);
+    for (; Base == 16 && len >= 8; len -= 8, input += 8)
+        r = r << 32 | parse8hex(input);
+    for (; len; --len, ++input)
+        r = r * Base + digit<Base>(*input);
+    return r;
+}
+
+// Convert the number of base 'Base' at 'input' to '*v'.
+// Return the address of the character which follows the number.
+// Return 'input' if 'input' has no digit. Return 0 if the number does not fit
+// 64 bits.
+template <int Base>
+static const char* parseradix(const char* input, uint64_t* v)
+{
+    // The number of digits, which always fit 64 bits.
+    const size_t fit = Base == 16 ? 16 : Base == 10 ? 19 : 21;
+    const char* b = input;
+    while ('0' == *b)
+        ++b;
+    const char* p = b;
+    while (digit<Base>(*p) < (unsigned) Base)
+        ++p;
+    const size_t len = p - b;
+    if (len <= fit) {
+        *v = parsedigits<Base>(b, len);
+        return p;
+    }
+    if (len > fit + 1)
         return 0;
-    char* r;
-    errno = 0;
-    const T v = str2f<T>(input, &r);
-    if (errno || r == input)
+    // One more digit fits, if the number is small enough.
+    const uint64_t r = parsedigits<Base>(b, fit);
+    const uint64_t d = digit<Base>(b[fit]);
+    if (r > (std::numeric_limits<uint64_t>::max() - d) / Base)
         return 0;
+    *v = r * Base + d;
+    return p;
+}
+
+// Read an integer of base 'Base'.
+template <int Base, class T>
+static const char* readradix(const char* input, const char* sep, T* result,
+                             const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* p = input;
+    const int neg = *p == '-';
+    if (neg || *p == '+')
+        ++p;
+    uint64_t v = 0;
+    const char* r = parseradix<Base>(p, &v);
+    if (!r)
+        return fail(stats_t::overflow);
+    if (r == p)
+        return unconverted(input, sep);
+    const bool is_signed = std::numeric_limits<T>::is_signed;
+    const uint64_t max = std::numeric_limits<T>::max();
+    if (is_signed ? v > max + neg : v > max || (neg && v))
+        return fail(stats_t::overflow);
     if (result)
-        *result = v;
-    return next(r, sep);
+        *result = neg ? (T) (-(long long) (v - 1) - 1) : (T) v;
+    return next(r, sep, e);
 }
 
-const char* read(const char* input, const char* sep, float* result)
+#ifdef have_int128
+typedef libtext::uint128_t uint128;
+
+// Convert 'len' digits of base 'Base' at 'input', which fit 128 bits.
+// The digits are converted to 64 bit words by parsedigits, the most
+// significant word first, and each word is appended with one 128 bit multiply
+// or shift.
+template <int Base>
+static uint128 parsedigits128(const char* input, size_t len)
 {
-    return readfloat(input, sep, result);
+    // The number of digits per word and 'Base' to this power.
+    const size_t n = Base == 16 ? 16 : Base == 10 ? 19 : 21;
+    const uint128 scale = Base == 10 ? (uint128) 10000000000000000000ull
+                                     : (uint128) 1 << (Base == 16 ? 64 : 63);
+    // The first word holds the digits, which do not fill a whole word.
+    const size_t k = len ? (len - 1) % n + 1 : 0;
+    uint128 r = parsedigits<Base>(input, k);
+    for (input += k, len -= k; len; input += n, len -= n)
+        r = r * scale + parsedigits<Base>(input, n);
+    return r;
 }
 
-const char* read(const char* input, const char* sep, double* result)
+// Same as parseradix, but the number has to fit 128 bits.
+template <int Base>
+static const char* parseradix128(const char* input, uint128* v)
 {
-    return readfloat(input, sep, result);
+    // The number of digits, which always fit 128 bits.
+    const size_t fit = Base == 16 ? 32 : Base == 10 ? 38 : 42;
+    const char* b = input;
+    while ('0' == *b)
+        ++b;
+    const char* p = b;
+    while (digit<Base>(*p) < (unsigned) Base)
+        ++p;
+    const size_t len = p - b;
+    if (len <= fit) {
+        *v = parsedigits128<Base>(b, len);
+        return p;
+    }
+    if (len > fit + 1)
+        return 0;
+    // One more digit fits, if the number is small enough.
+    const uint128 r = parsedigits128<Base>(b, fit);
+    const unsigned d = digit<Base>(b[fit]);
+    if (r > (~(uint128) 0 - d) / Base)
+        return 0;
+    *v = r * Base + d;
+    return p;
 }
 
-const char* read(const char* input, const char* sep, long double* result)
+// The max value of the type of 'result'.
+static uint128 max128(const libtext::int128_t*)
 {
-    return readfloat(input, sep, result);
+    return ~(uint128) 0 >> 1;
 }
 
-const char* read(const char* input, const char* sep, int result)
+static uint128 max128(const uint128*)
 {
-    assert(!result);
-    return read(input, sep, (std::string*) 0);
+    return ~(uint128) 0;
 }
 
-const char* nextline(const char* input)
+// Same as readll and readull for a 128 bit integer.
+// The number is hexadecimal if it begins with 0x or 0X, octal if it begins
+// with 0 and decimal otherwise, as strtoll has it.
+template <class T>
+static const char* read128(const char* input, const char* sep, T* result,
+                           const libtext::empty_fields* e)
 {
-    while (*input && *input++ != '\n');
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* p = input;
+    const int neg = *p == '-';
+    if (neg || *p == '+')
+        ++p;
+    uint128 v = 0;
+    const char* r;
+    if (*p == '0' && (p[1] | 0x20) == 'x' && digit<16>(p[2]) < 16)
+        r = parseradix128<16>(p + 2, &v);
+    else if (*p == '0')
+        r = parseradix128<8>(p, &v);
+    else
+        r = parseradix128<10>(p, &v);
+    if (!r)
+        return fail(stats_t::overflow);
+    if (r == p)
+        return unconverted(input, sep);
+    // An unsigned type takes the negation of any number, which fits, as
+    // strtoull has it.
+    const uint128 max = max128(result);
+    if (max != ~(uint128) 0 && v > max + neg)
+        return fail(stats_t::overflow);
+    if (result)
+        *result = (T) (neg ? 0 - v : v);
+    return next(r, sep, e);
+}
+#endif
+
+// Append decimal digit 'd' to '*m'. Return 0 if '*m' overflows.
+static int append(uint64_t* m, unsigned d)
+{
+    if (*m > (std::numeric_limits<uint64_t>::max() - d) / 10)
+        return 0;
+    *m = *m * 10 + d;
+    return 1;
+}
+
+// Read a fixed point decimal number to its mantissa without floating point.
+// The digits beyond the scale are rounded to the nearest, ties to even.
+static const char* readscaled(const char* input, const char* sep,
+                              libtext::detail::scaled* result,
+                              const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* p = input;
+    const int neg = *p == '-';
+    if (neg || *p == '+')
+        ++p;
+    while ('0' == *p && digit<10>(p[1]) < 10)
+        ++p; // Leading zeros.
+    const char* ib = p;
+    while (digit<10>(*p) < 10)
+        ++p;
+    const char* ie = p;
+    const char* fb = '.' == *p ? ++p : p;
+    while (digit<10>(*p) < 10)
+        ++p;
+    const char* fe = p;
+    if (ib == ie && fb == fe)
+        return unconverted(input, sep);
+    uint64_t m = 0;
+    const char* d = ib;
+    for (; d < ie; ++d)
+        if (!append(&m, *d - '0'))
+            return fail(stats_t::overflow);
+    d = fb;
+    for (int k = 0; k < result->scale; ++k)
+        if (!append(&m, d < fe ? *d++ - '0' : 0))
+            return fail(stats_t::overflow);
+    if (d < fe) {
+        // Round the dropped digits.
+        const unsigned first = *d - '0';
+        int sticky = 0;
+        while (++d < fe)
+            sticky |= '0' != *d;
+        if (first > 5 || (first == 5 && (sticky || (m & 1))))
+            if (++m == 0)
+                return fail(stats_t::overflow);
+    }
+    const uint64_t max = std::numeric_limits<int64_t>::max();
+    if (m > max + neg)
+        return fail(stats_t::overflow);
+    if (result->mantissa)
+        *result->mantissa = neg ? -(int64_t) (m - 1) - 1 : (int64_t) m;
+    return next(fe, sep, e);
+}
+
+// Convert the 'n' decimal digits at 'input' to '*v'.
+// Return the address of the character which follows the digits or 0 if
+// 'input' is 0 or any of the 'n' characters is not a digit.
+static const char* fixed(const char* input, int n, int* v)
+{
+    if (!input)
+        return 0;
+    int r = 0;
+    for (int k = 0; k < n; ++k) {
+        const unsigned d = digit<10>(input[k]);
+        if (d > 9)
+            return 0;
+        r = r * 10 + d;
+    }
+    *v = r;
+    return input + n;
+}
+
+// Return the address of the character which follows 'c', if 'input' begins
+// with 'c'. Return 0 otherwise.
+static const char* expect(const char* input, char c)
+{
+    return input && *input == c ? input + 1 : 0;
+}
+
+// The number of days from 1970-01-01 to 'y'-'m'-'d' of the proleptic
+// Gregorian calendar. The year begins on March 1 to have the leap day be the
+// last day of the year.
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned) (y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t) doe - 719468;
+}
+
+// Return 1 if 'y'-'m'-'d' is a valid date.
+static int valid_date(int y, int m, int d)
+{
+    static const int mdays[] = {
+        31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    if (m < 1 || m > 12 || d < 1 || d > mdays[m - 1])
+        return 0;
+    const int leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+    return m != 2 || d < 29 || leap;
+}
+
+// Convert the date and the time to '*ts' and return the address of 'input'.
+// Return 0 if the date or the time is invalid.
+static const char* civil(const char* input, int y, int mo, int d, int h,
+                         int mi, int sec, struct timespec* ts)
+{
+    // A leap second is accepted and is the first second of the next minute.
+    if (!valid_date(y, mo, d) || h > 23 || mi > 59 || sec > 60)
+        return 0;
+    ts->tv_sec = (time_t) (days_from_civil(y, mo, d) * 86400 + h * 3600
+                                                      + mi * 60 + sec);
     return input;
 }
 
-std::string oneline(const char* input)
+// Convert the fraction of a second at 'input', which follows the decimal
+// point, to '*ns'. Skip the digits beyond nanoseconds.
+static const char* fraction(const char* input, long* ns)
 {
-    return std::string(input, strcspn(input, "\n"));
+    long r = 0;
+    int k = 0;
+    for (; k < 9 && digit<10>(input[k]) < 10; ++k)
+        r = r * 10 + input[k] - '0';
+    if (k == 0)
+        return 0;
+    input += k;
+    for (; k < 9; ++k)
+        r *= 10;
+    while (digit<10>(*input) < 10)
+        ++input;
+    *ns = r;
+    return input;
+}
+
+// Convert the optional fraction of a second at 'input' to 'ts->tv_nsec'.
+static const char* optfraction(const char* input, struct timespec* ts)
+{
+    ts->tv_nsec = 0;
+    if (input && ('.' == *input || ',' == *input))
+        return fraction(input + 1, &ts->tv_nsec);
+    return input;
+}
+
+// Convert the time zone offset at 'input', i.e. +hh:mm, +hhmm or +hh, to
+// seconds east of UTC.
+static const char* offset(const char* input, int colon, long* off)
+{
+    const int neg = '-' == *input;
+    if (!neg && '+' != *input)
+        return 0;
+    int h, m = 0;
+    const char* p = fixed(input + 1, 2, &h);
+    if (p && colon && ':' == *p)
+        p = fixed(p + 1, 2, &m);
+    else if (p && digit<10>(*p) < 10)
+        p = fixed(p, 2, &m);
+    if (!p || h > 23 || m > 59)
+        return 0;
+    *off = (neg ? -1 : 1) * (h * 3600L + m * 60L);
+    return p;
+}
+
+// Read an ISO-8601 timestamp, e.g. 2026-10-10T13:55:36.25+02:00 or
+// 2026-10-10T13:55Z.
+static const char* iso8601(const char* input, struct timespec* ts)
+{
+    int y, mo, d, h = 0, mi = 0, sec = 0;
+    const char* p = fixed(input, 4, &y);
+    p = fixed(expect(p, '-'), 2, &mo);
+    p = fixed(expect(p, '-'), 2, &d);
+    if (!p)
+        return 0;
+    ts->tv_nsec = 0;
+    // A space before a time joins the date and the time.
+    const int time = 'T' == *p || 't' == *p
+        || (' ' == *p && digit<10>(p[1]) < 10 && digit<10>(p[2]) < 10
+                      && ':' == p[3]);
+    if (time) {
+        p = fixed(p + 1, 2, &h);
+        p = fixed(expect(p, ':'), 2, &mi);
+        // The seconds are optional. A fraction follows the seconds only.
+        if (p && ':' == *p) {
+            p = fixed(p + 1, 2, &sec);
+            p = optfraction(p, ts);
+        }
+        if (!p)
+            return 0;
+    }
+    long off = 0;
+    if ('Z' == *p || 'z' == *p)
+        ++p;
+    else if (time && ('+' == *p || '-' == *p) && !(p = offset(p, 1, &off)))
+        return 0;
+    if (!civil(p, y, mo, d, h, mi, sec, ts))
+        return 0;
+    ts->tv_sec -= off;
+    return p;
+}
+
+// Convert the abbreviated English name of a month at 'input' to 1-12.
+static const char* month(const char* input, int* m)
+{
+    static const char names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    for (int k = 0; k < 12; ++k)
+        if (!strncmp(input, names + 3 * k, 3)) {
+            *m = k + 1;
+            return input + 3;
+        }
+    return 0;
+}
+
+// Read a timestamp of the common log format, e.g.
+// [10/Oct/2026:13:55:36 +0000]. The brackets are optional.
+static const char* clf(const char* input, struct timespec* ts)
+{
+    const int bracket = '[' == *input;
+    int y = 0, mo = 0, d = 0, h = 0, mi = 0, sec = 0;
+    const char* p = fixed(input + bracket, 2, &d);
+    p = expect(p, '/');
+    p = p ? month(p, &mo) : 0;
+    p = fixed(expect(p, '/'), 4, &y);
+    p = fixed(expect(p, ':'), 2, &h);
+    p = fixed(expect(p, ':'), 2, &mi);
+    p = fixed(expect(p, ':'), 2, &sec);
+    p = optfraction(p, ts);
+    if (!p)
+        return 0;
+    long off = 0;
+    const char* z = ' ' == *p ? p + 1 : p;
+    if ('+' == *z || '-' == *z) {
+        if (!(p = offset(z, 0, &off)))
+            return 0;
+    }
+    if (bracket && !(p = expect(p, ']')))
+        return 0;
+    if (!civil(p, y, mo, d, h, mi, sec, ts))
+        return 0;
+    ts->tv_sec -= off;
+    return p;
+}
+
+// Read seconds since the epoch with an optional fraction, e.g. 1791640536.25.
+// Set '*overflow' if the seconds do not fit time_t.
+static const char* epoch(const char* input, struct timespec* ts,
+                         int* overflow)
+{
+    const int neg = '-' == *input;
+    const char* p = input + (neg || '+' == *input);
+    uint64_t v;
+    const char* r = parseradix<10>(p, &v);
+    if (!r) {
+        *overflow = 1;
+        return 0;
+    }
+    if (r == p)
+        return 0;
+    r = optfraction(r, ts);
+    if (!r)
+        return 0;
+    const uint64_t max = std::numeric_limits<time_t>::max();
+    if (v > max) {
+        *overflow = 1;
+        return 0;
+    }
+    ts->tv_sec = (time_t) v;
+    if (neg) {
+        ts->tv_sec = -ts->tv_sec;
+        if (ts->tv_nsec) {
+            // Keep the nanoseconds nonnegative.
+            --ts->tv_sec;
+            ts->tv_nsec = 1000000000 - ts->tv_nsec;
+        }
+    }
+    return r;
+}
+
+// Read a timestamp. The format is found from the first characters.
+static const char* readtime(const char* input, const char* sep,
+                            struct timespec* result,
+                            const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    struct timespec ts;
+    int overflow = 0;
+    const char* r;
+    int v;
+    if ('[' == *input || (fixed(input, 2, &v) && '/' == input[2]))
+        r = clf(input, &ts);
+    else if (fixed(input, 4, &v) && '-' == input[4])
+        r = iso8601(input, &ts);
+    else
+        r = epoch(input, &ts, &overflow);
+    if (overflow)
+        return fail(stats_t::overflow);
+    if (!r)
+        return unconverted(input, sep);
+    if (result)
+        *result = ts;
+    return next(r, sep, e);
+}
+
+// Convert the decimal number at 'input', which has an optional fraction, e.g.
+// 1.5, to its integer part '*ip' and the 'n' digits of its fraction at
+// '*frac'.
+// Return the address of the character which follows the number.
+// Return 'input' if 'input' has no digit. Return 0 if the integer part does
+// not fit 64 bits.
+static const char* decfraction(const char* input, uint64_t* ip,
+                               const char** frac, size_t* n)
+{
+    const char* p = parseradix<10>(input, ip);
+    *frac = p;
+    *n = 0;
+    if (p && '.' == *p && digit<10>(p[1]) < 10) {
+        const char* f = ++p;
+        while (digit<10>(*p) < 10)
+            ++p;
+        *frac = f;
+        *n = p - f;
+    }
+    return p;
+}
+
+// Store the number of integer part 'ip' and fraction digits 'frac'
+// multiplied by 'unit' to '*v'. The fraction of the product is truncated.
+// Return 0 if the product is greater than 'max'.
+static int multiply(uint64_t ip, const char* frac, size_t n, uint64_t unit,
+                    uint64_t max, uint64_t* v)
+{
+    // The digits of the fraction are added from the last one. The sum is
+    // less than 10 units, which fits 64 bits for any unit of libtext.
+    uint64_t f = 0;
+    while (n--)
+        f = (f + (frac[n] - '0') * unit) / 10;
+    if (f > max || ip > (max - f) / unit)
+        return 0;
+    *v = ip * unit + f;
+    return 1;
+}
+
+// Return 1 if a field ends at 'input'.
+static int fieldend(const char* input, const char* sep)
+{
+    return eol(input) || ws(input) || skipsep(input, sep);
+}
+
+// Store the multiple of the unit of size at 'input' to '*unit'.
+// A unit is k or K, M, G, T, P or E, which is 'kilo' to the power of 1 to 6,
+// or Ki or ki, Mi, Gi, Ti, Pi or Ei, which is 1024 to this power, followed by
+// an optional B, or a plain B. A lower case m is not mega.
+// Return the address of the character which follows the unit.
+static const char* sizeunit(const char* input, uint64_t kilo, uint64_t* unit)
+{
+    static const char prefixes[] = "KMGTPE";
+    const char c = 'k' == *input ? 'K' : *input;
+    const char* p = c ? strchr(prefixes, c) : 0;
+    *unit = 1;
+    if (p) {
+        if ('i' == *++input) {
+            kilo = 1024;
+            ++input;
+        }
+        for (int k = 0; k <= p - prefixes; ++k)
+            *unit *= kilo;
+    }
+    if ('B' == *input)
+        ++input;
+    return input;
+}
+
+// Read a size, e.g. 4K, 1.5G or 16318216 kB, to bytes.
+static const char* readsize(const char* input, const char* sep,
+                            libtext::size_field* result,
+                            const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    uint64_t ip = 0;
+    const char* frac;
+    size_t n;
+    const char* r = decfraction(input, &ip, &frac, &n);
+    if (!r)
+        return fail(stats_t::overflow);
+    if (r == input)
+        return unconverted(input, sep);
+    // The unit follows the number immediately, e.g. 4K, or after space, if
+    // the unit ends the field, e.g. 16318216 kB. If space separates the
+    // fields, then a word after space is the next field, e.g. 4 K 7.
+    const char* u = strpbrk(sep, " \t") ? r : skipws(r);
+    uint64_t unit;
+    const char* q = sizeunit(u, result->kilo, &unit);
+    if (u != r && (q == u || !fieldend(q, sep))) {
+        q = r;
+        unit = 1;
+    }
+    uint64_t v;
+    if (!multiply(ip, frac, n, unit, std::numeric_limits<uint64_t>::max(),
+                  &v))
+        return fail(stats_t::overflow);
+    if (result->result)
+        *result->result = v;
+    return next(q, sep, e);
+}
+
+// Return the nanoseconds of the unit of duration at 'input' and store the
+// address of the character which follows the unit to '*end'.
+// Return 0 if 'input' has no unit.
+static uint64_t durationunit(const char* input, const char** end)
+{
+    static const struct {
+        const char* name;
+        uint64_t ns;
+    } units[] = {
+        {"ns", 1}, {"us", 1000}, {"\xc2\xb5s", 1000}, {"ms", 1000000},
+        {"s", 1000000000}, {"min", 60000000000ull}, {"m", 60000000000ull},
+        {"h", 3600000000000ull}, {"d", 86400000000000ull},
+        {"w", 604800000000000ull}
+    };
+    for (size_t k = 0; k < sizeof units / sizeof units[0]; ++k) {
+        const size_t len = strlen(units[k].name);
+        if (!strncmp(input, units[k].name, len)) {
+            *end = input + len;
+            return units[k].ns;
+        }
+    }
+    return 0;
+}
+
+// Read a duration, e.g. 250ms or 1h30m, to nanoseconds.
+static const char* readduration(const char* input, const char* sep,
+                                libtext::detail::duration_ns* result,
+                                const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    const char* p = input;
+    const int neg = *p == '-';
+    if (neg || *p == '+')
+        ++p;
+    const char* const b = p;
+    const uint64_t max = std::numeric_limits<int64_t>::max();
+    uint64_t total = 0;
+    do {
+        uint64_t ip = 0;
+        const char* frac;
+        size_t n;
+        const char* r = decfraction(p, &ip, &frac, &n);
+        if (!r)
+            return fail(stats_t::overflow);
+        if (r == p)
+            return unconverted(input, sep);
+        const int first = p == b;
+        uint64_t unit = durationunit(r, &p);
+        if (!unit) {
+            // A number without a unit is seconds, unless it follows another
+            // component, e.g. 1h30.
+            if (!first)
+                return fail(stats_t::invalid_value);
+            unit = 1000000000;
+            p = r;
+        }
+        uint64_t v;
+        if (!multiply(ip, frac, n, unit, max - total, &v))
+            return fail(stats_t::overflow);
+        total += v;
+    } while (digit<10>(*p) < 10 || ('.' == *p && digit<10>(p[1]) < 10));
+    if (result->ns)
+        *result->ns = neg ? -(int64_t) total : (int64_t) total;
+    return next(p, sep, e);
+}
+
+// Return the address of the character which follows 'token', if the field at
+// 'input' is 'token'. Return 0 otherwise.
+static const char* istoken(const char* input, const char* sep,
+                           const char* token)
+{
+    input = skipws(input);
+    const size_t len = strlen(token);
+    if (strncmp(input, token, len) || !fieldend(input + len, sep))
+        return 0;
+    return input + len;
+}
+
+// Skip the placeholder field at 'input' and set '*result->found'. If the
+// field is not the placeholder, then clear '*result->found' and return
+// 'input' intact for the caller to read the field as a value. Thus, the field
+// is scanned once. The caller counts the bytes as of a skipped field and only
+// a placeholder, which is found, counts as a placeholder field.
+static const char* readplaceholder(const char* input, const char* sep,
+                                   libtext::detail::placeholder* result,
+                                   const libtext::empty_fields* e)
+{
+    const char* s = istoken(input, sep, result->token);
+    *result->found = s != 0;
+    if (!s)
+        return input;
+    s = next(s, sep, e);
+    return s ? counted(stats_t::placeholder, s, s) : 0;
+}
+
+// Convert the IPv4 address in dotted decimal notation at 'input' to 'a' in
+// network byte order. A part has at most 3 digits and no leading zero, the
+// same as for inet_pton.
+static const char* parse4(const char* input, unsigned char* a)
+{
+    for (int k = 0; k < 4; ++k) {
+        if (k && '.' != *input++)
+            return 0;
+        const char* b = input;
+        unsigned v = 0;
+        for (; input - b < 3 && digit<10>(*input) < 10; ++input)
+            v = v * 10 + *input - '0';
+        if (input == b || v > 255 || (input - b > 1 && '0' == *b))
+            return 0;
+        if (digit<10>(*input) < 10)
+            return 0;
+        a[k] = (unsigned char) v;
+    }
+    return input;
+}
+
+// Convert the IPv6 address at 'input' to 'a' in network byte order.
+// The address is at most 8 groups of at most 4 hexadecimal digits, separated
+// by ':'. One '::' stands for one or more groups of zeros. The last 2 groups
+// can be an IPv4 address. A ':', which follows the address and is not
+// followed by a hexadecimal digit, is not a part of the address.
+static const char* parse6(const char* input, unsigned char* a)
+{
+    unsigned char g[16];
+    int n = 0; // Bytes parsed.
+    int gap = -1; // The position of '::'.
+    const char* p = input;
+    if (':' == *p) {
+        if (':' != p[1])
+            return 0;
+        p += 2;
+        gap = 0;
+    }
+    while (n < 16 && digit<16>(*p) < 16) {
+        const char* b = p;
+        unsigned v = 0;
+        for (; p - b < 4 && digit<16>(*p) < 16; ++p)
+            v = v * 16 + digit<16>(*p);
+        if ('.' == *p) {
+            // An IPv4 address in the last 2 groups.
+            if (n > 12 || !(p = parse4(b, g + n)))
+                return 0;
+            n += 4;
+            break;
+        }
+        if (digit<16>(*p) < 16)
+            return 0; // More than 4 digits.
+        g[n++] = (unsigned char) (v >> 8);
+        g[n++] = (unsigned char) v;
+        if (':' != *p)
+            break;
+        if (':' == p[1]) {
+            if (gap >= 0)
+                return 0; // The second '::'.
+            gap = n;
+            p += 2;
+        } else if (digit<16>(p[1]) < 16)
+            ++p;
+        else
+            break;
+    }
+    if (gap < 0 ? n != 16 : n > 14)
+        return 0;
+    // Move the groups, which follow '::', to the end.
+    memset(a, 0, 16);
+    if (gap < 0)
+        gap = n;
+    memcpy(a, g, gap);
+    memcpy(a + 16 - (n - gap), g + gap, n - gap);
+    return p;
+}
+
+// Convert the IPv6 address at 'input', which may be in brackets.
+static const char* bracket6(const char* input, unsigned char* a)
+{
+    if ('[' != *input)
+        return parse6(input, a);
+    return expect(parse6(input + 1, a), ']');
+}
+
+static const char* readin4(const char* input, const char* sep,
+                           struct in_addr* result,
+                           const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    unsigned char a[4];
+    const char* r = parse4(input, a);
+    if (!r)
+        return unconverted(input, sep);
+    if (result)
+        memcpy(&result->s_addr, a, 4);
+    return next(r, sep, e);
+}
+
+static const char* readin6(const char* input, const char* sep,
+                           struct in6_addr* result,
+                           const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    if (':' == *sep && '[' != *input)
+        return fail(stats_t::invalid_value); // Ambiguous.
+    unsigned char a[16];
+    const char* r = bracket6(input, a);
+    if (!r)
+        return unconverted(input, sep);
+    if (result)
+        memcpy(result->s6_addr, a, 16);
+    return next(r, sep, e);
+}
+
+// Store 'port' to 'p' in network byte order.
+static void netport(unsigned port, void* p)
+{
+    unsigned char* b = static_cast<unsigned char*>(p);
+    b[0] = (unsigned char) (port >> 8);
+    b[1] = (unsigned char) port;
+}
+
+static const char* readsockaddr(const char* input, const char* sep,
+                                struct sockaddr_storage* result,
+                                const libtext::empty_fields* e)
+{
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    unsigned char a[16];
+    int v4 = 0;
+    const char* r = parse4(input, a);
+    if (r)
+        v4 = 1;
+    else
+        r = bracket6(input, a);
+    if (!r)
+        return unconverted(input, sep);
+    uint64_t port = 0;
+    if (':' == *r && (v4 || '[' == *input)) {
+        const char* p = r + 1;
+        if ('0' == *p && digit<10>(p[1]) < 10)
+            return fail(stats_t::invalid_value);
+        if ((r = parseradix<10>(p, &port)) == p)
+            return unconverted(input, sep);
+        if (!r || port > 65535)
+            return fail(stats_t::overflow);
+    }
+    if (result) {
+        memset(result, 0, sizeof *result);
+        if (v4) {
+            struct sockaddr_in* sin = (struct sockaddr_in*) result;
+            sin->sin_family = AF_INET;
+            netport((unsigned) port, &sin->sin_port);
+            memcpy(&sin->sin_addr, a, 4);
+        } else {
+            struct sockaddr_in6* sin6 = (struct sockaddr_in6*) result;
+            sin6->sin6_family = AF_INET6;
+            netport((unsigned) port, &sin6->sin6_port);
+            memcpy(sin6->sin6_addr.s6_addr, a, 16);
+        }
+    }
+    return next(r, sep, e);
+}
+
+// Return the address of the character which follows the 'n' hexadecimal
+// digits at 'input' or 0 if 'input' is 0 or has fewer digits.
+static const char* hexdigits(const char* input, size_t n)
+{
+    if (!input)
+        return 0;
+    for (const char* end = input + n; input < end; ++input)
+        if (digit<16>(*input) > 15)
+            return 0;
+    return input;
+}
+
+// Convert the 2 * 'n' hexadecimal digits at 'input' to the 'n' bytes at
+// 'out'. 8 digits are converted at once.
+static void hexpairs(const char* input, size_t n, unsigned char* out)
+{
+    for (; n >= 4; n -= 4, input += 8, out += 4) {
+        const uint64_t v = parse8hex(input);
+        out[0] = (unsigned char) (v >> 24);
+        out[1] = (unsigned char) (v >> 16);
+        out[2] = (unsigned char) (v >> 8);
+        out[3] = (unsigned char) v;
+    }
+    for (; n; --n, input += 2, ++out)
+        *out = (unsigned char) (digit<16>(input[0]) << 4 |
+                                digit<16>(input[1]));
+}
+
+// Validate the 'n' groups of hexadecimal digits at 'input', which are
+// separated by 'dash', and convert them to the bytes at 'out'. Group 'k' has
+// 'bytes[k]' bytes. The bytes are intact if the groups are malformed.
+// Return the address of the character which follows the last group or 0.
+static const char* hexgroups(const char* input, const unsigned char* bytes,
+                             int n, char dash, unsigned char* out)
+{
+    const char* p = hexdigits(input, 2 * bytes[0]);
+    for (int k = 1; k < n; ++k)
+        p = hexdigits(expect(p, dash), 2 * bytes[k]);
+    if (!p)
+        return 0;
+    for (int k = 0; k < n; input += 2 * bytes[k] + 1, out += bytes[k], ++k)
+        hexpairs(input, bytes[k], out);
+    return p;
+}
+
+// Return the value of base64 digit 'c' or 64 if 'c' is not a digit.
+static unsigned sextet(char c)
+{
+    if ((unsigned) (c - 'A') < 26)
+        return c - 'A';
+    if ((unsigned) (c - 'a') < 26)
+        return c - 'a' + 26;
+    if ((unsigned) (c - '0') < 10)
+        return c - '0' + 52;
+    return c == '+' ? 62 : c == '/' ? 63 : 64;
+}
+
+// Read a hexadecimal, uuid, mac or base64 field to the bytes of the caller.
+// The field is validated while it is scanned and is converted only if valid.
+static const char* readbinary(const char* input, const char* sep,
+                              libtext::binary_field* result,
+                              const libtext::empty_fields* e)
+{
+    typedef libtext::binary_field bf;
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    unsigned char* out = result->data;
+    const char* p = 0;
+    switch (result->encoding) {
+    case bf::hexdigits:
+        if ((p = hexdigits(input, 2 * result->size)))
+            hexpairs(input, result->size, out);
+        break;
+    case bf::uuid: {
+        static const unsigned char bytes[] = {4, 2, 2, 2, 6};
+        p = hexgroups(input, bytes, 5, '-', out);
+        break;
+    }
+    case bf::mac: {
+        static const unsigned char bytes[] = {1, 1, 1, 1, 1, 1};
+        const char dash = hexdigits(input, 2) && input[2] == '-' ? '-' : ':';
+        p = hexgroups(input, bytes, 6, dash, out);
+        break;
+    }
+    case bf::base64: {
+        const char* d = input;
+        while (sextet(*d) < 64)
+            ++d;
+        const size_t n = d - input;
+        size_t pad = 0;
+        while (pad < 2 && d[pad] == '=')
+            ++pad;
+        if (n == 0 || (n + pad) % 4)
+            break;
+        const size_t len = (n + pad) / 4 * 3 - pad;
+        if (len > result->size)
+            return fail(stats_t::overflow);
+        // 4 digits are combined to 3 bytes at once.
+        const char* q = input;
+        for (; q + 4 <= d; q += 4, out += 3) {
+            const uint32_t v = sextet(q[0]) << 18 | sextet(q[1]) << 12 |
+                               sextet(q[2]) << 6 | sextet(q[3]);
+            out[0] = (unsigned char) (v >> 16);
+            out[1] = (unsigned char) (v >> 8);
+            out[2] = (unsigned char) v;
+        }
+        if (pad) {
+            const uint32_t v = sextet(q[0]) << 18 | sextet(q[1]) << 12 |
+                               (pad == 1 ? sextet(q[2]) << 6 : 0);
+            out[0] = (unsigned char) (v >> 16);
+            if (pad == 1)
+                out[1] = (unsigned char) (v >> 8);
+        }
+        if (result->len)
+            *result->len = len;
+        p = d + pad;
+        break;
+    }
+    }
+    if (!p)
+        return unconverted(input, sep);
+    return next(p, sep, e);
+}
+
+// Convert with the converter of the base of 'result'.
+template <class T>
+static const char* readbase(const char* input, const char* sep,
+                            libtext::radix_field<T>* result,
+                            const libtext::empty_fields* e)
+{
+    switch (result->base) {
+    case 16:
+        return readradix<16>(input, sep, result->result, e);
+    case 8:
+        return readradix<8>(input, sep, result->result, e);
+    default:
+        assert(10 == result->base);
+        return readradix<10>(input, sep, result->result, e);
+    }
+}
+
+// Read at most 'result.size' remaining fields of type 'type'.
+template <class T>
+static const char* readints(int type, const char* input, const char* sep,
+                            libtext::span_field<T> result)
+{
+    size_t n = 0;
+    for (; n < result.size && !libtext::detail::nomore(input); ++n)
+        if (!(input = field(type, input, sep, result.data + n, readdec)))
+            break;
+    *result.count = n;
+    return input;
+}
+
+namespace libtext
+{
+const char* read(const char* input, const char* sep, std::string* result)
+{
+    return field(stats_t::string, input, sep, result, reads);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 std::string* result)
+{
+    return field(stats_t::string, input, sep.sep, result, reads, &sep);
+}
+
+#ifdef have_string_view
+const char* read(const char* input, const char* sep, std::string_view* result)
+{
+    return field(stats_t::string_view, input, sep, result, reads);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 std::string_view* result)
+{
+    return field(stats_t::string_view, input, sep.sep, result, reads, &sep);
+}
+#endif
+
+const char* read(const char* input, const char* sep, uint8_t* result)
+{
+    return field(stats_t::uint8, input, sep, result, readull);
+}
+
+const char* read(const char* input, const empty_fields& sep, uint8_t* result)
+{
+    return field(stats_t::uint8, input, sep.sep, result, readull, &sep);
+}
+
+const char* read(const char* input, const char* sep, uint16_t* result)
+{
+    return field(stats_t::uint16, input, sep, result, readull);
+}
+
+const char* read(const char* input, const empty_fields& sep, uint16_t* result)
+{
+    return field(stats_t::uint16, input, sep.sep, result, readull, &sep);
+}
+
+const char* read(const char* input, const char* sep, uint32_t* result)
+{
+    return field(stats_t::uint32, input, sep, result, readull);
+}
+
+const char* read(const char* input, const empty_fields& sep, uint32_t* result)
+{
+    return field(stats_t::uint32, input, sep.sep, result, readull, &sep);
+}
+
+const char* read(const char* input, const char* sep, uint64_t* result)
+{
+    return field(stats_t::uint64, input, sep, result, readull);
+}
+
+const char* read(const char* input, const empty_fields& sep, uint64_t* result)
+{
+    return field(stats_t::uint64, input, sep.sep, result, readull, &sep);
+}
+
+const char* read(const char* input, const char* sep, int8_t* result)
+{
+    return field(stats_t::int8, input, sep, result, readll);
+}
+
+const char* read(const char* input, const empty_fields& sep, int8_t* result)
+{
+    return field(stats_t::int8, input, sep.sep, result, readll, &sep);
+}
+
+const char* read(const char* input, const char* sep, int16_t* result)
+{
+    return field(stats_t::int16, input, sep, result, readll);
+}
+
+const char* read(const char* input, const empty_fields& sep, int16_t* result)
+{
+    return field(stats_t::int16, input, sep.sep, result, readll, &sep);
+}
+
+const char* read(const char* input, const char* sep, int32_t* result)
+{
+    return field(stats_t::int32, input, sep, result, readll);
+}
+
+const char* read(const char* input, const empty_fields& sep, int32_t* result)
+{
+    return field(stats_t::int32, input, sep.sep, result, readll, &sep);
+}
+
+const char* read(const char* input, const char* sep, int64_t* result)
+{
+    return field(stats_t::int64, input, sep, result, readll);
+}
+
+const char* read(const char* input, const empty_fields& sep, int64_t* result)
+{
+    return field(stats_t::int64, input, sep.sep, result, readll, &sep);
+}
+
+#ifdef have_int128
+const char* read(const char* input, const char* sep, int128_t* result)
+{
+    return field(stats_t::int128, input, sep, result, read128);
+}
+
+const char* read(const char* input, const empty_fields& sep, int128_t* result)
+{
+    return field(stats_t::int128, input, sep.sep, result, read128, &sep);
+}
+
+const char* read(const char* input, const char* sep, uint128_t* result)
+{
+    return field(stats_t::uint128, input, sep, result, read128);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 uint128_t* result)
+{
+    return field(stats_t::uint128, input, sep.sep, result, read128, &sep);
+}
+#endif
+
+template <class T>
+static T str2f(const char* input, char** end);
+
+template <>
+float str2f<float>(const char* input, char** end)
+{
+    return strtof(input, end);
+}
+
+template <>
+double str2f<double>(const char* input, char** end)
+{
+    return strtod(input, end);
+}
+
+template <>
+long double str2f<long double>(const char* input, char** end)
+{
+    return strtold(input, end);
+}
+
+template <class T>
+static const char* readfloat(const char* input, const char* sep, T* result,
+                             const libtext::empty_fields* e)
+{
+    // strtoull skips leading space, \t, \n, \v, \f, \r.
+    // Detect malformed input by skipping " \t" and checking if the following
+    // char is a space as determined by isspace.
+    input = skipws(input);
+    if (empty(input, sep, e))
+        return skipempty(input, sep, e); // Keep the default value.
+    if (isspace((unsigned char) *input))
+        return unconverted(input, sep);
+    char* r;
+    errno = 0;
+    const T v = str2f<T>(input, &r);
+    if (errno)
+        return converror();
+    if (r == input)
+        return unconverted(input, sep);
+    if (result)
+        *result = v;
+    return next(r, sep, e);
+}
+
+const char* read(const char* input, const char* sep, float* result)
+{
+    return field(stats_t::flt, input, sep, result, readfloat);
+}
+
+const char* read(const char* input, const empty_fields& sep, float* result)
+{
+    return field(stats_t::flt, input, sep.sep, result, readfloat, &sep);
+}
+
+const char* read(const char* input, const char* sep, double* result)
+{
+    return field(stats_t::dbl, input, sep, result, readfloat);
+}
+
+const char* read(const char* input, const empty_fields& sep, double* result)
+{
+    return field(stats_t::dbl, input, sep.sep, result, readfloat, &sep);
+}
+
+const char* read(const char* input, const char* sep, long double* result)
+{
+    return field(stats_t::ldbl, input, sep, result, readfloat);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 long double* result)
+{
+    return field(stats_t::ldbl, input, sep.sep, result, readfloat, &sep);
+}
+
+const char* read(const char* input, const char* sep, int result)
+{
+    assert(!result);
+    return field(-1, input, sep, (std::string*) 0, reads);
+}
+
+const char* read(const char* input, const empty_fields& sep, int result)
+{
+    assert(!result);
+    return field(-1, input, sep.sep, (std::string*) 0, reads, &sep);
+}
+
+const char* read(const char* input, const char* sep, span_field<int8_t> result)
+{
+    return readints(stats_t::int8, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<int16_t> result)
+{
+    return readints(stats_t::int16, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<int32_t> result)
+{
+    return readints(stats_t::int32, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<int64_t> result)
+{
+    return readints(stats_t::int64, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<uint8_t> result)
+{
+    return readints(stats_t::uint8, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<uint16_t> result)
+{
+    return readints(stats_t::uint16, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<uint32_t> result)
+{
+    return readints(stats_t::uint32, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 span_field<uint64_t> result)
+{
+    return readints(stats_t::uint64, input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 list_field<std::string> result)
+{
+    return readlist(input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+                 list_field<std::pair<std::string, std::string> > result)
+{
+    return readlist(input, sep, result);
+}
+
+#ifdef have_string_view
+const char* read(const char* input, const char* sep,
+                 list_field<std::string_view> result)
+{
+    return readlist(input, sep, result);
+}
+
+const char* read(const char* input, const char* sep,
+            list_field<std::pair<std::string_view, std::string_view> > result)
+{
+    return readlist(input, sep, result);
+}
+#endif
+
+const char* read(const char* input, const char* sep,
+                 unescape_field<std::string> result)
+{
+    return field(stats_t::string, input, sep, &result, readunescaped);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 unescape_field<std::string> result)
+{
+    return field(stats_t::string, input, sep.sep, &result, readunescaped,
+                 &sep);
+}
+
+#ifdef have_string_view
+const char* read(const char* input, const char* sep,
+                 unescape_field<std::string_view> result)
+{
+    return field(stats_t::string_view, input, sep, &result, readunescaped);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 unescape_field<std::string_view> result)
+{
+    return field(stats_t::string_view, input, sep.sep, &result,
+                 readunescaped, &sep);
+}
+#endif
+
+const char* read(const char* input, const char* sep,
+                 radix_field<uint8_t> result)
+{
+    return field(stats_t::uint8, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint8_t> result)
+{
+    return field(stats_t::uint8, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<uint16_t> result)
+{
+    return field(stats_t::uint16, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint16_t> result)
+{
+    return field(stats_t::uint16, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<uint32_t> result)
+{
+    return field(stats_t::uint32, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint32_t> result)
+{
+    return field(stats_t::uint32, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<uint64_t> result)
+{
+    return field(stats_t::uint64, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint64_t> result)
+{
+    return field(stats_t::uint64, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<int8_t> result)
+{
+    return field(stats_t::int8, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int8_t> result)
+{
+    return field(stats_t::int8, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<int16_t> result)
+{
+    return field(stats_t::int16, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int16_t> result)
+{
+    return field(stats_t::int16, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<int32_t> result)
+{
+    return field(stats_t::int32, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int32_t> result)
+{
+    return field(stats_t::int32, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<int64_t> result)
+{
+    return field(stats_t::int64, input, sep, &result, readbase);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int64_t> result)
+{
+    return field(stats_t::int64, input, sep.sep, &result, readbase, &sep);
+}
+
+const char* read(const char* input, const char* sep, detail::scaled result)
+{
+    return field(stats_t::decimal, input, sep, &result, readscaled);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 detail::scaled result)
+{
+    return field(stats_t::decimal, input, sep.sep, &result, readscaled,
+                 &sep);
+}
+
+const char* read(const char* input, const char* sep, struct timespec* result)
+{
+    return field(stats_t::timestamp, input, sep, result, readtime);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 struct timespec* result)
+{
+    return field(stats_t::timestamp, input, sep.sep, result, readtime, &sep);
+}
+
+const char* read(const char* input, const char* sep, struct in_addr* result)
+{
+    return field(stats_t::address, input, sep, result, readin4);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 struct in_addr* result)
+{
+    return field(stats_t::address, input, sep.sep, result, readin4, &sep);
+}
+
+const char* read(const char* input, const char* sep, struct in6_addr* result)
+{
+    return field(stats_t::address, input, sep, result, readin6);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 struct in6_addr* result)
+{
+    return field(stats_t::address, input, sep.sep, result, readin6, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 struct sockaddr_storage* result)
+{
+    return field(stats_t::address, input, sep, result, readsockaddr);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 struct sockaddr_storage* result)
+{
+    return field(stats_t::address, input, sep.sep, result, readsockaddr, &sep);
+}
+
+namespace detail
+{
+perfect_set::perfect_set()
+    : seed(0), bits(1), bbits(1)
+{
+    table.assign(2, -1);
+    disp.assign(2, 0);
+}
+
+size_t perfect_set::add(const char* key)
+{
+    // The keys, which were appended after the last build, are not in the
+    // table yet. Equal keys would have equal hashes under any seed.
+    const size_t k = std::find(keys.begin(), keys.end(), key) - keys.begin();
+    if (k == keys.size())
+        keys.push_back(key);
+    return k;
+}
+
+void perfect_set::build()
+{
+    perfect_hash(keys, &table, &disp, &seed, &bits, &bbits);
+}
+
+int perfect_set::find(const char* key, size_t len) const
+{
+    const uint64_t h = keyhash(seed, key, len);
+    const int k = table[hashslot(h, disp[hashbucket(h, bbits)], bits)];
+    if (k < 0 || keys[k].size() != len || memcmp(keys[k].data(), key, len))
+        return -1;
+    return k;
+}
+} // detail
+
+keyset::keyset(const char* kvsep_, const char* pairsep_)
+    : kvsep(kvsep_), pairsep(pairsep_), nmatched(0), nunknown(0), built(true)
+{
+}
+
+void keyset::add(const char* key, void* value, reader convert)
+{
+    const size_t k = keys.add(key);
+    const entry e = {value, convert};
+    if (k < entries.size()) {
+        entries[k] = e; // Rebind.
+        return;
+    }
+    entries.push_back(e);
+    built = false; // Build once, when read needs the table.
+}
+
+const char* read(const char* input, const char* sep,
+                 detail::custom_field result)
+{
+    return field(stats_t::custom, input, sep, &result, readcustom);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 detail::custom_field result)
+{
+    return field(stats_t::custom, input, sep.sep, &result, readcustom, &sep);
+}
+
+const char* read(const char* input, const char* sep, size_field result)
+{
+    return field(stats_t::size, input, sep, &result, readsize);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 size_field result)
+{
+    return field(stats_t::size, input, sep.sep, &result, readsize, &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 detail::duration_ns result)
+{
+    return field(stats_t::duration, input, sep, &result, readduration);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 detail::duration_ns result)
+{
+    return field(stats_t::duration, input, sep.sep, &result, readduration,
+                 &sep);
+}
+
+const char* read(const char* input, const char* sep,
+                 detail::placeholder result)
+{
+    return field(-1, input, sep, &result, readplaceholder);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 detail::placeholder result)
+{
+    return field(-1, input, sep.sep, &result, readplaceholder, &sep);
+}
+
+const char* read(const char* input, const char* sep, binary_field result)
+{
+    return field(stats_t::binary, input, sep, &result, readbinary);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 binary_field result)
+{
+    return field(stats_t::binary, input, sep.sep, &result, readbinary, &sep);
+}
+
+symbols::symbols(const symbol* s, size_t n)
+{
+    for (size_t k = 0; k < n; ++k) {
+        const size_t j = names.add(s[k].name);
+        if (j < values.size())
+            values[j] = s[k].value;
+        else
+            values.push_back(s[k].value);
+    }
+    names.build();
+}
+
+const int64_t* symbols::find(const char* name, size_t len) const
+{
+    const int k = names.find(name, len);
+    return k >= 0 ? &values[k] : 0;
+}
+
+const char* read(const char* input, const char* sep,
+                 detail::symbol_field result)
+{
+    return field(stats_t::symbol, input, sep, &result, readsymbol);
+}
+
+const char* read(const char* input, const empty_fields& sep,
+                 detail::symbol_field result)
+{
+    return field(stats_t::symbol, input, sep.sep, &result, readsymbol, &sep);
+}
+
+// Decode the double quoted value at 'input', whose \" and \\ stand for " and
+// \, and append the value and a null terminator to '*result', unless 'result'
+// is null. Return the address, which follows the closing quote, or 0 if the
+// line has no closing quote.
+static const char* unquote(const char* input, std::string* result)
+{
+    const char* p = input + 1;
+    for (; !eol(p) && '"' != *p; ++p) {
+        if ('\\' == *p && ('"' == p[1] || '\\' == p[1]))
+            ++p;
+        if (result)
+            result->push_back(*p);
+    }
+    if ('"' != *p)
+        return 0;
+    if (result)
+        result->push_back(0);
+    return p + 1;
+}
+
+const char* read(const char* input, keyset& keys)
+{
+    if (!keys.built) {
+        keys.keys.build();
+        keys.built = true;
+    }
+    // The value of a pair on its own line is the first word.
+    const char* valuesep = keys.pairsep ? keys.pairsep : " ";
+    keys.nmatched = keys.nunknown = 0;
+    keys.unquoted.clear();
+    for (;;) {
+        if (keys.pairsep) {
+            input = skipws(input);
+            if (eol(input))
+                return input;
+        } else {
+            while (*input == '\n')
+                ++input; // Skip empty lines.
+            if (!*input)
+                return input;
+        }
+        const char* key = skipws(input);
+        const char* end = nextsep(key, keys.kvsep);
+        if (eol(end))
+            return fail(stats_t::missing_separator);
+        if (keys.pairsep && nextsep(key, keys.pairsep) < end)
+            return fail(stats_t::missing_separator); // A pair without kvsep.
+        const char* value = skipsep(end, keys.kvsep);
+        while (end > key && ws(end - 1))
+            --end;
+        if (end == key)
+            return fail(stats_t::missing_field);
+        const int k = keys.keys.find(key, end - key);
+        const keyset::entry* e = k >= 0 ? &keys.entries[k] : 0;
+        const char* s;
+        const char* q = skipws(value);
+        if (keys.pairsep && '"' == *q) {
+            // The decoded values of a line are no longer than the line. Thus,
+            // the buffer does not move and the values, which refer to the
+            // buffer, stay valid.
+            if (keys.unquoted.empty())
+                keys.unquoted.reserve(strcspn(q, "\n"));
+            const size_t n = keys.unquoted.size();
+            s = unquote(q, e ? &keys.unquoted : 0);
+            if (!s)
+                return fail(stats_t::missing_separator);
+            if (!eol(s) && !(s = skipsep(s, keys.pairsep)))
+                return fail(stats_t::missing_separator);
+            // The value holds no newline. Thus, the converter reads the
+            // whole value as one field.
+            if (e && !e->convert(keys.unquoted.data() + n, "\n", e->value))
+                return 0;
+            if (e)
+                ++keys.nmatched;
+            else
+                ++keys.nunknown;
+        } else if (e) {
+            s = e->convert(value, valuesep, e->value);
+            if (!s)
+                return 0;
+            ++keys.nmatched;
+        } else {
+            ++keys.nunknown;
+            s = nextsep(value, valuesep);
+            if (!eol(s))
+                s = skipsep(s, valuesep);
+        }
+        // Skip the rest of a line, e.g. the unit kB of /proc/meminfo.
+        input = keys.pairsep ? s : nextline(s);
+    }
+}
+
+const char* nextline(const char* input)
+{
+    while (*input && *input++ != '\n');
+    return input;
+}
+
+std::string oneline(const char* input)
+{
+    return std::string(input, strcspn(input, "\n"));
+}
+
+statistics stats()
+{
+    statistics result = statistics();
+#ifdef LIBTEXT_STATS
+    registry& r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    result = r.retired;
+    for (const counters* c: r.live)
+        sum(&result, *c);
+#endif
+    return result;
 }
 } // libtext
 
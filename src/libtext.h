@@ -2,15 +2,43 @@
 #define LIBTEXT_INCLUDE_GUARD
 
 #include <string>
+#include <vector>
+#include <array>
+#include <utility>
+#include <chrono>
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #undef have_string_view
 #if defined __has_include && __has_include(<string_view>)\
                                                     && __cplusplus >= 201703L
 #include <string_view>
 #define have_string_view 1
 #endif
+#undef have_optional
+#if defined __has_include && __has_include(<optional>)\
+                                                    && __cplusplus >= 201703L
+#include <optional>
+#define have_optional 1
+#endif
+#undef have_int128
+#ifdef __SIZEOF_INT128__
+#define have_int128 1
+#endif
+
+// The addresses are read to the structs of <netinet/in.h> and
+// <sys/socket.h>, which the caller includes to use them.
+struct in_addr;
+struct in6_addr;
+struct sockaddr_storage;
 
 namespace libtext {
+#ifdef have_int128
+// The 128 bit integers of the compiler. __extension__ keeps -Wpedantic quiet.
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
 const char* read(const char* input, const char* sep, std::string* result);
 #ifdef have_string_view
 const char* read(const char* input, const char* sep, std::string_view* result);
@@ -23,33 +51,931 @@ const char* read(const char* input, const char* sep, int8_t* result);
 const char* read(const char* input, const char* sep, int16_t* result);
 const char* read(const char* input, const char* sep, int32_t* result);
 const char* read(const char* input, const char* sep, int64_t* result);
+#ifdef have_int128
+// 128 bit identifiers, counters and notionals, where the compiler has them.
+const char* read(const char* input, const char* sep, int128_t* result);
+const char* read(const char* input, const char* sep, uint128_t* result);
+#endif
 const char* read(const char* input, const char* sep, float* result);
 const char* read(const char* input, const char* sep, double* result);
 const char* read(const char* input, const char* sep, long double* result);
 const char* read(const char* input, const char* sep, int result);
+
+// A separator, which allows empty fields, e.g. the empty comment of a user in
+// /etc/passwd or the empty list of members of a group in /etc/group.
+//     read(line, libtext::empty_fields(":"), &name, 0, &uid, &gid, &gecos)
+// A separator followed by another separator or by the end of the line
+// delimits an empty field. An empty field assigns an empty string to a string
+// and keeps a number intact, i.e. a number keeps the value, which the caller
+// set as the default. Otherwise, read is as strict as with a plain separator,
+// e.g. a line with fewer fields than output arguments is still malformed.
+// A space or tab separator separates no empty fields.
+// The empty last field is found among the fields of one call of read, e.g.
+// "a:b:" has 3 fields, if read with 3 output arguments. read does not modify
+// the separator. Thus, one separator can be reused for many lines and shared
+// by threads.
+struct empty_fields {
+    explicit empty_fields(const char* s) : sep(s), trailing(0) {}
+    const char* sep;
+    // The end of the line, which follows the last separator read by this
+    // call of read, if any. read tells an empty last field from a missing
+    // field by '*trailing', which is a local of the call. See
+    // detail::percall.
+    const char** trailing;
+};
+const char* read(const char* input, const empty_fields& sep,
+                 std::string* result);
+#ifdef have_string_view
+const char* read(const char* input, const empty_fields& sep,
+                 std::string_view* result);
+#endif
+const char* read(const char* input, const empty_fields& sep, uint8_t* result);
+const char* read(const char* input, const empty_fields& sep, uint16_t* result);
+const char* read(const char* input, const empty_fields& sep, uint32_t* result);
+const char* read(const char* input, const empty_fields& sep, uint64_t* result);
+const char* read(const char* input, const empty_fields& sep, int8_t* result);
+const char* read(const char* input, const empty_fields& sep, int16_t* result);
+const char* read(const char* input, const empty_fields& sep, int32_t* result);
+const char* read(const char* input, const empty_fields& sep, int64_t* result);
+#ifdef have_int128
+const char* read(const char* input, const empty_fields& sep, int128_t* result);
+const char* read(const char* input, const empty_fields& sep,
+                 uint128_t* result);
+#endif
+const char* read(const char* input, const empty_fields& sep, float* result);
+const char* read(const char* input, const empty_fields& sep, double* result);
+const char* read(const char* input, const empty_fields& sep,
+                 long double* result);
+const char* read(const char* input, const empty_fields& sep, int result);
+
+// A customization point for field types of the user, e.g. an instrument id.
+// Specialize converter for the type with a static member function convert,
+// which converts the field [begin, end) to '*result' and returns false if
+// the field is malformed.
+//     namespace libtext {
+//     template <>
+//     struct converter<isin> {
+//         static bool convert(const char* begin, const char* end,
+//                             isin* result);
+//     };
+//     }
+//     read(line, " ", &id, &price)
+// read skips the space, finds the field and checks the separators and the
+// end of the line, the same way as for a type of libtext. The field, which
+// is passed to convert, is not empty and has no space around.
+template <class T>
+struct converter;
+
+namespace detail {
+typedef bool (*convert_fn)(const char* begin, const char* end, void* result);
+
+template <class T>
+bool convert(const char* begin, const char* end, void* result)
+{
+    return converter<T>::convert(begin, end, static_cast<T*>(result));
+}
+
+// A field of a type of the user and its converter.
+struct custom_field {
+    void* result;
+    convert_fn convert;
+};
+} // detail
+
+const char* read(const char* input, const char* sep,
+                 detail::custom_field result);
+const char* read(const char* input, const empty_fields& sep,
+                 detail::custom_field result);
+
+// This overload takes part only for a type, which has a converter.
+// It is declared before the templates, which read a T, e.g. to a
+// std::vector<T>, to be found for a T of any namespace.
+template <class S, class T>
+auto read(const char* input, const S& sep, T* result)
+    -> decltype(converter<T>::convert(input, input, result),
+                static_cast<const char*>(0))
+{
+    return read(input, sep, detail::custom_field{result, detail::convert<T>});
+}
+
+// An optional trailing field, e.g. a column appended by a newer version of a
+// format. If the line has no more fields, then read assigns 'def' to
+// '*result'. Otherwise, read reads the field to '*result'.
+//     read(line, ":", &host, libtext::optional(&port, 80))
+template <class T>
+struct optional_field {
+    T* result;
+    T def;
+};
+
+template <class T, class D>
+optional_field<T> optional(T* result, const D& def)
+{
+    return optional_field<T>{result, T(def)};
+}
+
+namespace detail {
+// Return the address of the end of the line at 'input', if the line has no
+// more fields. Return 0 otherwise.
+inline const char* nomore(const char* input)
+{
+    while (*input == ' ' || *input == '\t')
+        ++input;
+    return !*input || *input == '\n' ? input : 0;
+}
+
+inline const char* nomore(const char* input, const char*)
+{
+    return nomore(input);
+}
+
+// The end of the line, which follows a trailing separator, delimits an empty
+// field, rather than no field.
+inline const char* nomore(const char* input, const empty_fields& sep)
+{
+    const char* s = nomore(input);
+    return s && sep.trailing && s == *sep.trailing ? 0 : s;
+}
+
+// Return the separator of one call of read, which reads several fields.
+// A copy of an empty_fields points at '*trailing' to keep the state of the
+// call, unless the separator is such a copy already.
+inline const char* percall(const char* sep, const char**)
+{
+    return sep;
+}
+
+inline empty_fields percall(const empty_fields& sep, const char** trailing)
+{
+    empty_fields s = sep;
+    if (!s.trailing) {
+        *trailing = 0;
+        s.trailing = trailing;
+    }
+    return s;
+}
+} // detail
+
+template <class S, class T>
+const char* read(const char* input, const S& sep, optional_field<T> result)
+{
+    if (const char* s = detail::nomore(input, sep)) {
+        *result.result = result.def;
+        return s;
+    }
+    return read(input, sep, result.result);
+}
+
+#ifdef have_optional
+// An optional trailing field. If the line has no more fields, then read resets
+// '*result'.
+template <class S, class T>
+const char* read(const char* input, const S& sep, std::optional<T>* result)
+{
+    if (const char* s = detail::nomore(input, sep)) {
+        result->reset();
+        return s;
+    }
+    // Read to a copy to keep '*result' intact should the read fail.
+    T v = *result ? **result : T();
+    const char* s = read(input, sep, &v);
+    if (s)
+        *result = std::move(v);
+    return s;
+}
+#endif
+
+// The remaining fields of a line, e.g. the aliases of a host in /etc/hosts
+// or the counters of a cpu in /proc/stat, read to a caller array.
+// read reads at most 'size' fields to 'data' and stores the number of fields
+// read to '*count'. The line may have no more fields.
+//     read(line, " ", &cpu, libtext::span(counters, 16, &n))
+template <class T>
+struct span_field {
+    T* data;
+    size_t size;
+    size_t* count;
+};
+
+template <class T>
+span_field<T> span(T* data, size_t size, size_t* count)
+{
+    return span_field<T>{data, size, count};
+}
+
+// Integers are converted in batches, see libtext.cpp.
+const char* read(const char* input, const char* sep,
+                 span_field<int8_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<int16_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<int32_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<int64_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<uint8_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<uint16_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<uint32_t> result);
+const char* read(const char* input, const char* sep,
+                 span_field<uint64_t> result);
+
+template <class S, class T>
+const char* read(const char* input, const S& sep, span_field<T> result)
+{
+    const char* trailing;
+    const auto& fields = detail::percall(sep, &trailing);
+    size_t n = 0;
+    for (; n < result.size && !detail::nomore(input, fields); ++n)
+        if (!(input = read(input, fields, result.data + n)))
+            break;
+    *result.count = n;
+    return input;
+}
+
+// Read all remaining fields of a line to '*result'.
+// If the line is malformed, then '*result' holds the fields read before the
+// malformed one.
+template <class S, class T>
+const char* read(const char* input, const S& sep, std::vector<T>* result)
+{
+    const char* trailing;
+    const auto& fields = detail::percall(sep, &trailing);
+    result->clear();
+    while (!detail::nomore(input, fields)) {
+        // Grow geometrically and read the next fields in one batch.
+        const size_t n = result->size();
+        const size_t room = n < 16 ? 16 : n;
+        size_t count = 0;
+        result->resize(n + room);
+        input = read(input, fields, span(result->data() + n, room, &count));
+        result->resize(n + count);
+        if (!input)
+            return 0;
+    }
+    return input;
+}
+
+// Read exactly N fields to '*result'.
+template <class S, class T, size_t N>
+const char* read(const char* input, const S& sep, std::array<T, N>* result)
+{
+    const char* trailing;
+    const auto& fields = detail::percall(sep, &trailing);
+    size_t count = 0;
+    input = read(input, fields, span(result->data(), N, &count));
+    if (!input || count == N)
+        return input;
+    // The line has fewer fields. Let read fail on the first missing field.
+    return read(input, fields, result->data() + count);
+}
+
+// A field, which is a list of items separated by 'sep', e.g. the mount
+// options rw,noatime,errors=remount-ro of /etc/fstab.
+// read clears '*result' and appends each item of the field to '*result' in
+// the same pass, which reads the field. The field is not copied.
+// If V is a std::pair, then each item is split to a key and a value at the
+// first 'kvsep', e.g. errors=remount-ro. An item without 'kvsep' has an
+// empty value, e.g. rw.
+// The field, an item and a key shall not be empty.
+//     std::vector<std::pair<std::string_view, std::string_view>> opts;
+//     read(line, " ", &spec, &file, &type, libtext::list(&opts, ","))
+template <class V>
+struct list_field {
+    std::vector<V>* result;
+    const char* sep;
+    const char* kvsep;
+};
+
+template <class V>
+list_field<V> list(std::vector<V>* result, const char* sep,
+                   const char* kvsep = "=")
+{
+    return list_field<V>{result, sep, kvsep};
+}
+
+const char* read(const char* input, const char* sep,
+                 list_field<std::string> result);
+const char* read(const char* input, const char* sep,
+                 list_field<std::pair<std::string, std::string> > result);
+#ifdef have_string_view
+const char* read(const char* input, const char* sep,
+                 list_field<std::string_view> result);
+const char* read(const char* input, const char* sep,
+            list_field<std::pair<std::string_view, std::string_view> > result);
+#endif
+
+// A fixed point decimal number, e.g. a price or a quantity, which has 'Scale'
+// digits after the decimal point. The value is mantissa / 10^Scale.
+// read converts the field exactly, without floating point. The digits beyond
+// 'Scale' are rounded to the nearest, ties to even, e.g. decimal<2> reads
+// 1.005 as 100 and 1.015 as 102. A value, which does not fit the mantissa,
+// is an overflow. An exponent is not accepted.
+//     libtext::decimal<4> price;
+//     read("IBM 142.3575", " ", &ticker, &price)
+template <int Scale>
+struct decimal {
+    static_assert(Scale >= 0 && Scale <= 18, "mantissa is int64_t");
+    int64_t mantissa;
+};
+
+namespace detail {
+// The mantissa and the scale of a decimal.
+struct scaled {
+    int64_t* mantissa;
+    int scale;
+};
+} // detail
+
+const char* read(const char* input, const char* sep, detail::scaled result);
+const char* read(const char* input, const empty_fields& sep,
+                 detail::scaled result);
+
+template <class S, int Scale>
+const char* read(const char* input, const S& sep, decimal<Scale>* result)
+{
+    return read(input, sep, detail::scaled{&result->mantissa, Scale});
+}
+
+// A timestamp, e.g. a column of a log. read accepts
+// - seconds since the epoch with an optional fraction, e.g. 1791640536.25,
+// - ISO-8601, e.g. 2026-10-10T13:55:36.25+02:00, 2026-10-10 13:55:36Z,
+//   2026-10-10T13:55Z or 2026-10-10, i.e. hh:mm with optional :ss,
+// - the common log format, e.g. [10/Oct/2026:13:55:36 +0000].
+// A timestamp without a time zone is UTC. A fraction has at most 9
+// significant digits. The space inside a timestamp separates no fields.
+// The digits of each part of a date and a time are converted at their fixed
+// offsets and the date is converted to days since the epoch arithmetically,
+// without libc time zone calls.
+//     struct timespec ts;
+//     read("[10/Oct/2026:13:55:36 +0000] GET", " ", &ts, &method)
+const char* read(const char* input, const char* sep, struct timespec* result);
+const char* read(const char* input, const empty_fields& sep,
+                 struct timespec* result);
+
+// Read a timestamp to a std::chrono::time_point of std::chrono::system_clock.
+// The timestamp is truncated to the duration of the time_point.
+template <class S, class D>
+const char* read(const char* input, const S& sep,
+                 std::chrono::time_point<std::chrono::system_clock, D>* result)
+{
+    using namespace std::chrono;
+    struct timespec ts;
+    ts.tv_nsec = -1; // An empty field keeps the default value.
+    const char* s = read(input, sep, &ts);
+    if (s && ts.tv_nsec >= 0)
+        *result = time_point<system_clock, D>(duration_cast<D>(
+                    seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec)));
+    return s;
+}
+
+// A size, e.g. 4K, 1.5G or 16318216 kB, read to bytes.
+// The unit is k or K, or upper case M, G, T, P or E, which is 'kilo' to the
+// power of 1 to 6, or Ki, Mi, Gi, Ti, Pi or Ei, which is 1024 to this power,
+// followed by an optional B. A lower case m is not mega, e.g. 4m is malformed. A plain B or no unit is bytes. Thus, the units
+// are binary by default, as in /proc/meminfo, and SI with a 'kilo' of 1000.
+// The unit follows the number immediately or, if 'sep' holds no space or tab,
+// after space, e.g. in /proc/meminfo, if the unit ends the field. The fraction
+// of a byte is truncated. A size, which does not fit uint64_t, is an overflow.
+//     uint64_t total;
+//     read("MemTotal:       16318216 kB", ":", 0, libtext::size(&total))
+struct size_field {
+    uint64_t* result;
+    uint64_t kilo; // 1000 or 1024.
+};
+
+inline size_field size(uint64_t* result, uint64_t kilo = 1024)
+{
+    return size_field{result, kilo};
+}
+
+const char* read(const char* input, const char* sep, size_field result);
+const char* read(const char* input, const empty_fields& sep,
+                 size_field result);
+
+// A duration, e.g. 250ms, 1.5s or 1h30m, read to a std::chrono::duration.
+// The units are ns, us, also with the UTF-8 micro sign, ms, s, m or min, h, d
+// and w. A duration has one or more numbers, each with a unit and an
+// optional fraction, and an optional sign. A single number without a unit is
+// seconds. The duration is truncated to the period of the
+// std::chrono::duration. A duration, which does not fit int64_t nanoseconds,
+// i.e. about 292 years, is an overflow.
+//     std::chrono::milliseconds timeout;
+//     read("timeout=1m30s", "=", 0, &timeout)
+namespace detail {
+struct duration_ns {
+    int64_t* ns;
+};
+} // detail
+
+const char* read(const char* input, const char* sep,
+                 detail::duration_ns result);
+const char* read(const char* input, const empty_fields& sep,
+                 detail::duration_ns result);
+
+template <class S, class R, class P>
+const char* read(const char* input, const S& sep,
+                 std::chrono::duration<R, P>* result)
+{
+    int64_t ns = INT64_MIN; // An empty field keeps the default value.
+    const char* s = read(input, sep, detail::duration_ns{&ns});
+    if (s && ns != INT64_MIN)
+        *result = std::chrono::duration_cast<std::chrono::duration<R, P> >(
+                    std::chrono::nanoseconds(ns));
+    return s;
+}
+
+// An IPv4 address in dotted decimal notation, e.g. 127.0.0.1, and an IPv6
+// address, e.g. fe80::1, ::ffff:127.0.0.1 or [::1], read as inet_pton
+// reads them.
+// The address is read up to its last character. Thus, a ':' separator
+// follows an IPv4 address, e.g. read("127.0.0.1:80", ":", &addr, &port).
+// Colons inside an IPv6 address cannot be told from a ':' separator. Thus,
+// if 'sep' begins with ':', then an IPv6 address must be in brackets, e.g.
+// read("[::1]:80", ":", &addr6, &port).
+const char* read(const char* input, const char* sep, struct in_addr* result);
+const char* read(const char* input, const char* sep, struct in6_addr* result);
+const char* read(const char* input, const empty_fields& sep,
+                 struct in_addr* result);
+const char* read(const char* input, const empty_fields& sep,
+                 struct in6_addr* result);
+
+// An IPv4 or IPv6 address and an optional port, e.g. 127.0.0.1:80, [::1]:80
+// or ::1, read to a struct sockaddr_in or a struct sockaddr_in6 in
+// '*result'. A port follows an IPv6 address only in brackets. The port of an
+// address without port is 0.
+const char* read(const char* input, const char* sep,
+                 struct sockaddr_storage* result);
+const char* read(const char* input, const empty_fields& sep,
+                 struct sockaddr_storage* result);
+
+// A string field, whose octal and backslash escapes are decoded, e.g. \040,
+// which stands for a space in a path in /etc/fstab or /proc/mounts.
+// An escape is a backslash followed by 1 to 3 octal digits or by one of
+// \ ' " a b f n r t v. Any other escape is malformed.
+// The escapes are decoded while the field is copied. A std::string_view
+// refers to the input, if the field has no backslash. Otherwise, the decoded
+// field is stored to '*buf' and the std::string_view refers to '*buf'. The
+// std::string_view is valid as long as the input and '*buf' are intact.
+//     std::string_view file;
+//     std::string buf;
+//     read(line, " ", &spec, libtext::unescape(&file, &buf))
+template <class S>
+struct unescape_field {
+    S* result;
+    std::string* buf;
+};
+
+inline unescape_field<std::string> unescape(std::string* result)
+{
+    return unescape_field<std::string>{result, 0};
+}
+
+const char* read(const char* input, const char* sep,
+                 unescape_field<std::string> result);
+const char* read(const char* input, const empty_fields& sep,
+                 unescape_field<std::string> result);
+#ifdef have_string_view
+inline unescape_field<std::string_view> unescape(std::string_view* result,
+                                                 std::string* buf)
+{
+    return unescape_field<std::string_view>{result, buf};
+}
+
+const char* read(const char* input, const char* sep,
+                 unescape_field<std::string_view> result);
+const char* read(const char* input, const empty_fields& sep,
+                 unescape_field<std::string_view> result);
+#endif
+
+// An integer field of base 'base', e.g. the hexadecimal address and port
+// 0100007F:0035 of /proc/net/udp.
+// A plain integer field has the base of its prefix, i.e. 010 is 8 and 0x10
+// is 16. An integer field of an explicit base has no prefix, i.e. dec reads
+// 010 as 10 and hex reads 0x10 as malformed. A sign is accepted. A value,
+// which does not fit the type, is an overflow, e.g. hex reads ffffffff to an
+// int32_t as an overflow, rather than as -1.
+// Decimal and hexadecimal digits are converted 8 at once.
+//     uint32_t addr;
+//     uint16_t port;
+//     read("0100007F:0035", ":", libtext::hex(&addr), libtext::hex(&port))
+template <class T>
+struct radix_field {
+    T* result;
+    int base; // 8, 10 or 16.
+};
+
+template <class T>
+radix_field<T> hex(T* result)
+{
+    return radix_field<T>{result, 16};
+}
+
+template <class T>
+radix_field<T> dec(T* result)
+{
+    return radix_field<T>{result, 10};
+}
+
+template <class T>
+radix_field<T> oct(T* result)
+{
+    return radix_field<T>{result, 8};
+}
+
+const char* read(const char* input, const char* sep,
+                 radix_field<uint8_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<uint16_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<uint32_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<uint64_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<int8_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<int16_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<int32_t> result);
+const char* read(const char* input, const char* sep,
+                 radix_field<int64_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint8_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint16_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint32_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<uint64_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int8_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int16_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int32_t> result);
+const char* read(const char* input, const empty_fields& sep,
+                 radix_field<int64_t> result);
+
+// A binary field, which is decoded to the bytes of the caller, e.g. a SHA
+// digest, a UUID, a MAC address or a base64 payload.
+// - hexbytes(data, size) reads exactly 2 * size hexadecimal digits.
+// - uuid(data) reads 16 bytes written as 8-4-4-4-12 hexadecimal digits,
+//   e.g. 123e4567-e89b-12d3-a456-426614174000.
+// - mac(data) reads 6 bytes written as 6 pairs of hexadecimal digits
+//   separated by colons or by dashes, e.g. 00:1a:2b:3c:4d:5e. The field has a
+//   fixed length. Thus, a ':' separator may follow a MAC address.
+// - base64(data, size, &len) reads padded base64 of at most 'size' bytes and
+//   stores the number of bytes to 'len'. A longer payload is an overflow.
+// The length and the digits are validated while the field is scanned and the
+// field is decoded only if valid. Hexadecimal digits are converted 8 at once.
+//     unsigned char digest[32];
+//     read(line, " ", libtext::hexbytes(digest, sizeof digest), &file)
+struct binary_field {
+    enum encoding_t { hexdigits, uuid, mac, base64 };
+    unsigned char* data;
+    size_t size;        // The capacity of 'data'.
+    size_t* len;        // The number of bytes decoded, if not null.
+    encoding_t encoding;
+};
+
+inline binary_field hexbytes(void* data, size_t size)
+{
+    return binary_field{static_cast<unsigned char*>(data), size, 0,
+                        binary_field::hexdigits};
+}
+
+inline binary_field uuid(void* data)
+{
+    return binary_field{static_cast<unsigned char*>(data), 16, 0,
+                        binary_field::uuid};
+}
+
+inline binary_field mac(void* data)
+{
+    return binary_field{static_cast<unsigned char*>(data), 6, 0,
+                        binary_field::mac};
+}
+
+inline binary_field base64(void* data, size_t size, size_t* len)
+{
+    return binary_field{static_cast<unsigned char*>(data), size, len,
+                        binary_field::base64};
+}
+
+const char* read(const char* input, const char* sep, binary_field result);
+const char* read(const char* input, const empty_fields& sep,
+                 binary_field result);
+
+namespace detail {
+// A set of strings, e.g. the keys of a keyset, and a perfect hash table of
+// the strings, which finds the index of a string with one hash of the string
+// and one comparison.
+class perfect_set {
+public:
+    perfect_set();
+    // Append 'key', unless present. Return the index of 'key'.
+    // Call build to find the appended keys.
+    size_t add(const char* key);
+    // Build the hash table of the keys.
+    void build();
+    // Return the index of the 'len' characters at 'key' or -1.
+    int find(const char* key, size_t len) const;
+
+private:
+    std::vector<std::string> keys;
+    std::vector<int> table; // The index of a key in 'keys' or -1.
+    std::vector<uint32_t> disp; // The displacement of each bucket.
+    uint64_t seed;
+    unsigned bits, bbits; // log2 of the number of slots and buckets.
+};
+} // detail
+
+// A set of keys, each bound to a variable, for lines of key/value pairs,
+// e.g. /proc/meminfo, memory.stat of a cgroup or logfmt.
+// 'kvsep' separates a key from its value. If 'pairsep' is null, then each
+// line holds one pair, e.g. "MemTotal:  16318216 kB", and the value is the
+// first word after 'kvsep'. Otherwise, the pairs of a line are separated by
+// 'pairsep', e.g. "level=info status=200", and a value may be double quoted,
+// as in logfmt, e.g. msg="hello world". A quoted value may hold 'pairsep',
+// \" and \\, which stand for " and \. The converter of the key receives the
+// value without the quotes. A std::string_view of a quoted value refers to the
+// keyset and is valid until the next read.
+//     uint64_t total, free;
+//     libtext::keyset keys(":");
+//     keys.bind("MemTotal", &total).bind("MemFree", &free);
+//     read(meminfo, keys);
+// The keys are looked up in a perfect hash table, which the first read after
+// a bind builds. Thus, read finds the variable of a key with one hash of the
+// key and one comparison. read writes the bound variables and the counters of
+// the keyset, thus a thread reads with a keyset of its own.
+class keyset {
+public:
+    explicit keyset(const char* kvsep, const char* pairsep = 0);
+    // Bind 'key' to '*value'. 'value' is an address of a variable of any of
+    // the types read accepts. Binding a key again rebinds the key.
+    template <class T>
+    keyset& bind(const char* key, T* value)
+    {
+        add(key, value, convert<T>);
+        return *this;
+    }
+    // The number of known and unknown keys found by the last read.
+    size_t matched() const { return nmatched; }
+    size_t unknown() const { return nunknown; }
+
+private:
+    typedef const char* (*reader)(const char*, const char*, void*);
+    template <class T>
+    static const char* convert(const char* input, const char* sep, void* r)
+    {
+        return read(input, sep, static_cast<T*>(r));
+    }
+    void add(const char* key, void* value, reader convert);
+    struct entry {
+        void* value;
+        reader convert;
+    };
+    detail::perfect_set keys;
+    std::vector<entry> entries; // The entry of each key of 'keys'.
+    const char* kvsep;
+    const char* pairsep;
+    size_t nmatched, nunknown;
+    bool built; // The hash table of 'keys' has every key bound.
+    // The quoted values of the last read without the quotes, each followed by
+    // a null terminator.
+    std::string unquoted;
+    friend const char* read(const char* input, keyset& keys);
+};
+
+// Read the key/value pairs at 'input' and convert the value of each known key
+// to its variable. Skip and count the pairs of unknown keys.
+// If 'keys' has no pair separator, then read all lines and return the address
+// of the null terminator. Otherwise, read the pairs of this line and return
+// the address of the end of the line.
+// If a line has no key, or no key separator, or the value of a known key is
+// malformed, then return 0.
+const char* read(const char* input, keyset& keys);
+
+// A name of a value of a closed vocabulary, e.g. the state R of a process or
+// the mount option noatime.
+struct symbol {
+    const char* name;
+    int64_t value;
+};
+
+// A closed vocabulary, e.g. the states of a process or the mount options.
+// The names are looked up in a perfect hash table, which the constructor
+// builds. Thus, a vocabulary is constructed once and read finds the value of
+// a name with one hash of the name and one comparison.
+//     enum state {running, sleeping, disk_sleep};
+//     const libtext::symbol names[] = {
+//         {"R", running}, {"S", sleeping}, {"D", disk_sleep}
+//     };
+//     static const libtext::symbols states(names);
+//     read(line, " ", &pid, &comm, libtext::one_of(&st, states))
+// A name, which is present twice, has the last of its values.
+class symbols {
+public:
+    symbols(const symbol* s, size_t n);
+    template <size_t N>
+    explicit symbols(const symbol (&s)[N]) : symbols(s, N) {}
+    // Return the address of the value of the 'len' characters at 'name' or 0
+    // if the name is unknown.
+    const int64_t* find(const char* name, size_t len) const;
+
+private:
+    detail::perfect_set names;
+    std::vector<int64_t> values; // The value of each name of 'names'.
+};
+
+namespace detail {
+// A field, which is a name of 'names', or, if 'listsep' is not null, a list
+// of names separated by 'listsep'. read sets '*converted', if read assigns
+// '*value'. An empty field assigns nothing.
+struct symbol_field {
+    int64_t* value;
+    const symbols* names;
+    const char* listsep;
+    size_t* unknown;
+    int* converted;
+};
+} // detail
+
+const char* read(const char* input, const char* sep,
+                 detail::symbol_field result);
+const char* read(const char* input, const empty_fields& sep,
+                 detail::symbol_field result);
+
+// A field, which is a name of a vocabulary, read to the value of the name.
+// An unknown name is malformed.
+template <class E>
+struct one_of_field {
+    E* result;
+    const symbols* names;
+};
+
+template <class E>
+one_of_field<E> one_of(E* result, const symbols& names)
+{
+    return one_of_field<E>{result, &names};
+}
+
+template <class S, class E>
+const char* read(const char* input, const S& sep, one_of_field<E> result)
+{
+    // An empty field keeps the default value.
+    int64_t v;
+    int converted = 0;
+    const char* s = read(input, sep, detail::symbol_field{&v, result.names,
+                                                          0, 0, &converted});
+    if (s && converted)
+        *result.result = static_cast<E>(v);
+    return s;
+}
+
+// A field, which is a list of names of a vocabulary separated by 'sep', e.g.
+// the mount options rw,noatime,nosuid, read to the bitwise or of the values
+// of the names. If 'unknown' is null, then an unknown name is malformed.
+// Otherwise, the unknown names are skipped and counted to '*unknown'.
+template <class E>
+struct flags_field {
+    E* result;
+    const symbols* names;
+    const char* sep;
+    size_t* unknown;
+};
+
+template <class E>
+flags_field<E> flags(E* result, const symbols& names, const char* sep = ",",
+                     size_t* unknown = 0)
+{
+    return flags_field<E>{result, &names, sep, unknown};
+}
+
+template <class S, class E>
+const char* read(const char* input, const S& sep, flags_field<E> result)
+{
+    // An empty field keeps the default value.
+    int64_t v;
+    int converted = 0;
+    const char* s = read(input, sep, detail::symbol_field{&v, result.names,
+                                                          result.sep,
+                                                          result.unknown,
+                                                          &converted});
+    if (s && converted)
+        *result.result = static_cast<E>(v);
+    return s;
+}
+
+// A field, which holds either a value or a placeholder of a missing value,
+// e.g. "-" in /proc/self/mountinfo, "*" in the output of netstat or "N/A" in
+// an exported CSV. If the field is 'token', then read assigns 'value' to
+// '*result'. Otherwise, read reads the field to '*result' as usual, e.g. a
+// number with the fast path of its type. 'token' is not empty. A field, which
+// begins with 'token', e.g. -1 for a token "-", is a value.
+//     double rtt;
+//     read(line, ",", &host, libtext::or_sentinel(&rtt, "N/A", -1.0))
+template <class T>
+struct sentinel_field {
+    T* result;
+    const char* token;
+    T value;
+};
+
+template <class T, class V>
+sentinel_field<T> or_sentinel(T* result, const char* token, const V& value)
+{
+    return sentinel_field<T>{result, token, T(value)};
+}
+
+namespace detail {
+// A placeholder of a missing value. read skips the field and sets '*found',
+// if the field is 'token'. Otherwise, read clears '*found' and returns the
+// input intact.
+struct placeholder {
+    const char* token;
+    int* found;
+};
+} // detail
+
+const char* read(const char* input, const char* sep,
+                 detail::placeholder result);
+const char* read(const char* input, const empty_fields& sep,
+                 detail::placeholder result);
+
+template <class S, class T>
+const char* read(const char* input, const S& sep, sentinel_field<T> result)
+{
+    int found;
+    const char* s = read(input, sep, detail::placeholder{result.token,
+                                                         &found});
+    if (!found)
+        return read(input, sep, result.result);
+    if (s)
+        *result.result = result.value;
+    return s;
+}
+
 // This definition is not static to have the generated function be an extern
 // weak symbol to have only one in the final binary, which reduces the image
 // size.  Having this definition static'd result in the generated function be a
 // static strong symbol with multiple of these in the final binary (for a
 // combination of arguments).
-template <class T, class... U>
-const char* read(const char* input, const char* sep, T result,  U... u)
+// 'sep' is either a string or empty_fields.
+template <class S, class T, class... U>
+const char* read(const char* input, const S& sep, T result,  U... u)
 {
-    const char* s = read(input, sep, result);
-    if (!s || !*s || *s == '\n')
-        return 0; // The number of arguments exceeds the number of fields.
+    const char* trailing;
+    const auto& fields = detail::percall(sep, &trailing);
+    const char* s = read(input, fields, result);
+    // If the number of arguments exceeds the number of fields, then the read
+    // of the first missing field fails at the end of the line.
+    if (!s)
+        return 0;
 #ifdef __cpp_fold_expressions
     // Prefer fold expression over recursion, because
     // 1. Recursion consumes more stack. Even when the tail call is optimized.
     // 2. Recursive code generates more symbols.
-    ((s = read(s, sep, u)) && ...);
+    ((s = read(s, fields, u)) && ...);
     return s;
 #else
-    return read(s, sep, u...);
+    return read(s, fields, u...);
 #endif
 }
 const char *nextline(const char* input);
 std::string oneline(const char* input);
+
+// The counters of libtext summed over all threads.
+// The counters are maintained only when libtext is configured with
+// --enable-stats. Otherwise, they compile to nothing and stats() returns
+// zeros.
+struct statistics {
+    // The types of fields.
+    enum {
+        int8, int16, int32, int64, uint8, uint16, uint32, uint64,
+        flt, dbl, ldbl, string, string_view, decimal, timestamp, address,
+        symbol, custom, int128, uint128, binary, size,
+        duration, placeholder, ntypes
+    };
+    // The reasons why read fails.
+    enum {
+        missing_field,          // The line has fewer fields than requested.
+        overflow,               // The value does not fit the type.
+        invalid_value,          // The field cannot be converted to the type.
+        missing_separator,      // The field is followed by no separator.
+        consecutive_separators, // The field is followed by an empty field.
+        trailing_separator,     // The line ends with a separator.
+        nreasons
+    };
+    uint64_t bytes_scanned;     // The bytes consumed by successful reads.
+    uint64_t fields[ntypes];    // The fields converted, by type.
+    uint64_t failures[nreasons];// The failed reads, by reason.
+    uint64_t bytes_copied;      // The bytes copied to std::string.
+};
+// Return a snapshot of the counters.
+// The counters of a running thread are read without stopping the thread.
+statistics stats();
 } // libtext
 #endif
 
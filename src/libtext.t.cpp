@@ -7,6 +7,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <link.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 #ifdef have_string_view
 typedef std::string_view string_view_t;
@@ -16,6 +25,27 @@ typedef std::string string_view_t;
 
 static int verbose = 0;
 
+#ifdef have_int128
+// Print a 128 bit integer, which std::ostream cannot print.
+static std::ostream& operator<<(std::ostream& s, unsigned __int128 x)
+{
+    char buf[40];
+    char* p = buf + sizeof buf;
+    *--p = '\0';
+    do
+        *--p = (char) ('0' + x % 10);
+    while (x /= 10);
+    return s << p;
+}
+
+static std::ostream& operator<<(std::ostream& s, __int128 x)
+{
+    if (x < 0)
+        return s << '-' << (0 - (unsigned __int128) x);
+    return s << (unsigned __int128) x;
+}
+#endif
+
 template <class T>
 static std::string tos(T x)
 {
@@ -675,6 +705,103 @@ static void case15(int line)
 
 }
 
+// Test that the batch conversion of 'number' in the middle of a line
+// agrees with the conversion of a single field.
+template <class T>
+static void batch(const char* number)
+{
+    const std::string line = std::string("1,") + number + ",2";
+    T x = 5;
+    const char* s = libtext::read(number, "", &x);
+    T y[3] = {5, 5, 5};
+    size_t n = 0;
+    const char* b = libtext::read(line.c_str(), ",", libtext::span(y, 3, &n));
+    ASSERT(!s == !b, number, s, b);
+    ASSERT(n == (s ? 3u : 1u), number, n);
+    ASSERT(x == y[1], number, tos(x), tos(y[1]));
+}
+
+namespace market {
+// An instrument id of 12 characters, e.g. US0378331005.
+struct isin {
+    char code[12];
+};
+}
+
+namespace libtext {
+// A converter of a type of the user.
+template <>
+struct converter<market::isin> {
+    static bool convert(const char* begin, const char* end,
+                        market::isin* result)
+    {
+        if (end - begin != 12)
+            return false;
+        for (const char* p = begin; p < end; ++p)
+            if (!isalnum((unsigned char) *p))
+                return false;
+        memcpy(result->code, begin, 12);
+        return true;
+    }
+};
+}
+
+// Store to 'result' the name of the ELF object, which has 'addr'.
+static int object_of(struct dl_phdr_info* info, size_t, void* result)
+{
+    std::string* path = static_cast<std::string*>(result);
+    const ElfW(Addr) addr = reinterpret_cast<ElfW(Addr)>(&libtext::nextline);
+    for (int k = 0; k < info->dlpi_phnum; ++k) {
+        const ElfW(Phdr)& ph = info->dlpi_phdr[k];
+        const ElfW(Addr) beg = info->dlpi_addr + ph.p_vaddr;
+        if (ph.p_type == PT_LOAD && addr >= beg && addr < beg + ph.p_memsz) {
+            *path = *info->dlpi_name ? info->dlpi_name : "/proc/self/exe";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Return the usdt probes of libtext as "provider:name args", read from
+// section .note.stapsdt of the ELF object, which has libtext::nextline.
+static std::vector<std::string> probes()
+{
+    std::vector<std::string> result;
+    std::string path;
+    dl_iterate_phdr(object_of, &path);
+    ASSERT(!path.empty());
+    std::ifstream f(path.c_str(), std::ios::binary);
+    const std::string elf((std::istreambuf_iterator<char>(f)),
+                          std::istreambuf_iterator<char>());
+    ASSERT(elf.size() > sizeof(ElfW(Ehdr)), path);
+    const char* base = elf.data();
+    const ElfW(Ehdr)* eh = reinterpret_cast<const ElfW(Ehdr)*>(base);
+    const ElfW(Shdr)* sh = reinterpret_cast<const ElfW(Shdr)*>(base
+                                                              + eh->e_shoff);
+    const char* names = base + sh[eh->e_shstrndx].sh_offset;
+    for (int k = 0; k < eh->e_shnum; ++k) {
+        if (strcmp(names + sh[k].sh_name, ".note.stapsdt"))
+            continue;
+        const char* p = base + sh[k].sh_offset;
+        const char* end = p + sh[k].sh_size;
+        while (p < end) {
+            const ElfW(Nhdr)* nh = reinterpret_cast<const ElfW(Nhdr)*>(p);
+            const char* name = p + sizeof *nh;
+            const char* desc = name + ((nh->n_namesz + 3) & ~3);
+            p = desc + ((nh->n_descsz + 3) & ~3);
+            if (nh->n_type != 3 || strcmp(name, "stapsdt"))
+                continue;
+            // The probe address, the base address and the semaphore address
+            // are followed by the provider, the name and the arguments.
+            const char* provider = desc + 3 * sizeof(ElfW(Addr));
+            const char* probe = provider + strlen(provider) + 1;
+            const char* args = probe + strlen(probe) + 1;
+            result.push_back(std::string(provider) + ":" + probe + " " + args);
+        }
+    }
+    return result;
+}
+
 int main(int argc, char* argv[])
 {
     const int test = argc > 1 ? atoi(argv[1]) : 0;
@@ -862,6 +989,10 @@ int main(int argc, char* argv[])
         test_int<uint32_t>(__LINE__);
         test_int<int64_t>(__LINE__);
         test_int<uint64_t>(__LINE__);
+#ifdef have_int128
+        test_int<__int128>(__LINE__);
+        test_int<unsigned __int128>(__LINE__);
+#endif
         break;
     case 8:
         int_underflow<int8_t>(__LINE__);
@@ -873,6 +1004,10 @@ int main(int argc, char* argv[])
         uint_underflow<uint16_t>(__LINE__);
         uint_underflow<uint32_t>(__LINE__);
         uint_underflow<uint64_t>(__LINE__);
+#ifdef have_int128
+        int_underflow<__int128>(__LINE__);
+        uint_underflow<unsigned __int128>(__LINE__);
+#endif
         break;
     case 9: {
             // float.
@@ -1015,6 +1150,1439 @@ int main(int argc, char* argv[])
         ASSERT("мир" == y, y);
         break;
     }
+    case 18: {
+        // stats.
+        typedef libtext::statistics st;
+        const st before = libtext::stats();
+        std::string host;
+        uint16_t port;
+        s = libtext::read("example.com:80", ":", &host, &port);
+        ASSERT(s && !*s, s);
+        std::string x, y;
+        ASSERT(!libtext::read("a::b", ":", &x, &y));
+        ASSERT(!libtext::read("a:", ":", &x));
+        int32_t k;
+        ASSERT(!libtext::read("a b", ":", &k));
+        ASSERT(!libtext::read("1 2", ":", &k));
+        ASSERT(!libtext::read("1", ":", &k, &k));
+        uint8_t u;
+        ASSERT(!libtext::read("300", "", &u));
+        std::thread t([] {
+            int64_t v;
+            ASSERT(!libtext::read("99999999999999999999", "", &v));
+        });
+        t.join();
+        const st after = libtext::stats();
+
+        st d;
+        d.bytes_scanned = after.bytes_scanned - before.bytes_scanned;
+        for (int k = 0; k < st::ntypes; ++k)
+            d.fields[k] = after.fields[k] - before.fields[k];
+        for (int k = 0; k < st::nreasons; ++k)
+            d.failures[k] = after.failures[k] - before.failures[k];
+        d.bytes_copied = after.bytes_copied - before.bytes_copied;
+#ifdef LIBTEXT_STATS
+        const uint64_t n = 1;
+#else
+        const uint64_t n = 0;
+#endif
+        // "example.com:", "80" and "1" are read successfully.
+        ASSERT(d.bytes_scanned == n * (12 + 2 + 1), d.bytes_scanned);
+        ASSERT(d.fields[st::string] == n, d.fields[st::string]);
+        ASSERT(d.fields[st::uint16] == n, d.fields[st::uint16]);
+        ASSERT(d.fields[st::int32] == n, d.fields[st::int32]);
+        ASSERT(d.fields[st::uint8] == 0, d.fields[st::uint8]);
+        ASSERT(d.fields[st::int64] == 0, d.fields[st::int64]);
+        // "a" is copied before the separators are validated.
+        ASSERT(d.bytes_copied == n * (11 + 1 + 1), d.bytes_copied);
+        const uint64_t* f = d.failures;
+        ASSERT(f[st::missing_field] == n, f[st::missing_field]);
+        ASSERT(f[st::overflow] == n * 2, f[st::overflow]);
+        ASSERT(f[st::invalid_value] == n, f[st::invalid_value]);
+        ASSERT(f[st::missing_separator] == n, f[st::missing_separator]);
+        ASSERT(f[st::consecutive_separators] == n,
+                                            f[st::consecutive_separators]);
+        ASSERT(f[st::trailing_separator] == n, f[st::trailing_separator]);
+        break;
+    }
+    case 19: {
+        // usdt probes.
+        const std::vector<std::string> v = probes();
+        int entry = 0, failure = 0;
+        for (size_t k = 0; k < v.size(); ++k) {
+            if (verbose)
+                std::cout << v[k] << std::endl;
+            if (v[k].compare(0, 19, "libtext:read_entry ") == 0) {
+                ++entry;
+                // The input and the type.
+                ASSERT(std::count(v[k].begin(), v[k].end(), '@') == 2, v[k]);
+            }
+            if (v[k].compare(0, 21, "libtext:read_failure ") == 0) {
+                ++failure;
+                // The input, the type and the reason.
+                ASSERT(std::count(v[k].begin(), v[k].end(), '@') == 3, v[k]);
+            }
+        }
+#ifdef LIBTEXT_PROBES
+        ASSERT(entry > 0, v.size());
+        ASSERT(failure > 0, v.size());
+#else
+        ASSERT(entry == 0, entry);
+        ASSERT(failure == 0, failure);
+#endif
+        // The probes do not change the result of read.
+        int32_t k = 2;
+        s = libtext::read("x", "", &k);
+        ASSERT(!s);
+        ASSERT(k == 2, k);
+        break;
+    }
+    case 20: {
+        // Empty fields.
+        const libtext::empty_fields colon(":");
+        std::string name, pw, gecos, home, shell = "x";
+        uint32_t uid = 7, gid = 7;
+        s = libtext::read("root:x:0:0::/root:", colon, &name, &pw, &uid, &gid,
+                          &gecos, &home, &shell);
+        ASSERT(s && !*s, s);
+        ASSERT(name == "root", name);
+        ASSERT(uid == 0 && gid == 0, uid, gid);
+        ASSERT(gecos.empty(), gecos);
+        ASSERT(home == "/root", home);
+        ASSERT(shell.empty(), shell);
+
+        // An empty number keeps the default value.
+        uid = 7;
+        gid = 8;
+        s = libtext::read("bin:x::", colon, &name, &pw, &uid, &gid);
+        ASSERT(s && !*s, s);
+        ASSERT(uid == 7 && gid == 8, uid, gid);
+
+        // Every field is empty.
+        std::string x = "x", y = "y", z = "z";
+        s = libtext::read(" : \t: ", colon, &x, &y, &z);
+        ASSERT(s && !*s, s);
+        ASSERT(x.empty() && y.empty() && z.empty(), x, y, z);
+
+        // The line has more fields than output arguments.
+        s = libtext::read("a::\nb", colon, &x, &y);
+        ASSERT(s && *s == '\n', s);
+        ASSERT(x == "a" && y.empty(), x, y);
+        // The empty last field belongs to the call of read, which read the
+        // trailing separator. Another call finds no more fields.
+        s = libtext::read(s, colon, &z);
+        ASSERT(!s);
+        s = libtext::read("a::\nb", colon, &x, &y, &z);
+        ASSERT(s && *s == '\n', s);
+        ASSERT(z.empty(), z);
+        s = libtext::read("a::", colon, &x, &y, &z, &z);
+        ASSERT(!s);
+
+        // The separator keeps no state of a line. Another line at the same
+        // address does not inherit the trailing separator of the last line.
+        char line[8] = "a:b:";
+        s = libtext::read(line, colon, &x, &y);
+        ASSERT(s && !*s, s);
+        memcpy(line, "a:bc", 5);
+        ASSERT(!libtext::read(line, colon, &x, &y, &z));
+        ASSERT(!colon.trailing);
+        memcpy(line, "a:b:", 5);
+        s = libtext::read(line, colon, &x, &y, &z);
+        ASSERT(s && !*s, s);
+        ASSERT(x == "a" && y == "b" && z.empty(), x, y, z);
+        memcpy(line, "a:bc", 5);
+        ASSERT(!libtext::read(line, colon, &x, &y, &z));
+
+        // A line with fewer fields than output arguments is still malformed.
+        s = libtext::read("a:b", colon, &x, &y, &z);
+        ASSERT(!s);
+        s = libtext::read("", colon, &x);
+        ASSERT(!s);
+        // A malformed value is still malformed.
+        s = libtext::read("a:b:c", colon, &x, &uid, &y);
+        ASSERT(!s);
+        // The number, which follows an empty field, is read.
+        s = libtext::read("::12", colon, &x, 0, &uid);
+        ASSERT(s && !*s, s);
+        ASSERT(uid == 12, uid);
+
+        // A plain separator still rejects empty fields.
+        ASSERT(!libtext::read("a::b", ":", &x, &y, &z));
+        ASSERT(!libtext::read("a:", ":", &x, &y));
+
+        // A space separates no empty fields.
+        s = libtext::read("a  b", libtext::empty_fields(" "), &x, &y);
+        ASSERT(s && !*s, s);
+        ASSERT(x == "a" && y == "b", x, y);
+
+        string_view_t v = "v";
+        s = libtext::read("a:", colon, &x, &v);
+        ASSERT(s && !*s, s);
+        ASSERT(v.empty(), v);
+        break;
+    }
+    case 21: {
+        // Optional trailing fields.
+        std::string host;
+        uint16_t port = 1;
+        std::string proto = "x";
+        s = libtext::read("example.com", ":", &host,
+                          libtext::optional(&port, 80),
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && !*s, s);
+        ASSERT(host == "example.com", host);
+        ASSERT(port == 80, port);
+        ASSERT(proto == "tcp", proto);
+
+        s = libtext::read("example.com:8080 \nx", ":", &host,
+                          libtext::optional(&port, 80),
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && *s == '\n', s);
+        ASSERT(port == 8080, port);
+        ASSERT(proto == "tcp", proto);
+
+        s = libtext::read("example.com:8080:udp", ":", &host,
+                          libtext::optional(&port, 80),
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && !*s, s);
+        ASSERT(port == 8080, port);
+        ASSERT(proto == "udp", proto);
+
+        // A present, but malformed optional field is malformed.
+        port = 1;
+        s = libtext::read("example.com:http", ":", &host,
+                          libtext::optional(&port, 80));
+        ASSERT(!s);
+        ASSERT(port == 1, port);
+        // A trailing separator is still malformed.
+        s = libtext::read("example.com:", ":", &host,
+                          libtext::optional(&port, 80));
+        ASSERT(!s);
+        // A mandatory field is still mandatory.
+        s = libtext::read("example.com", ":", &host, &port);
+        ASSERT(!s);
+
+        // With empty fields, an empty last field is present and empty.
+        const libtext::empty_fields colon(":");
+        s = libtext::read("example.com:", colon, &host,
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && !*s, s);
+        ASSERT(proto.empty(), proto);
+        s = libtext::read("example.com", colon, &host,
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && !*s, s);
+        ASSERT(proto == "tcp", proto);
+        // The empty last field of the previous line at the same address is
+        // not present in the next line.
+        char line[16] = "example.com:";
+        s = libtext::read(line, colon, &host, &port);
+        ASSERT(s && !*s, s);
+        memcpy(line, "example.com", 12);
+        proto = "x";
+        s = libtext::read(line, colon, &host,
+                          libtext::optional(&proto, "tcp"));
+        ASSERT(s && !*s, s);
+        ASSERT(proto == "tcp", proto);
+
+#ifdef have_optional
+        std::optional<uint16_t> p = 7;
+        std::optional<std::string> q;
+        s = libtext::read("example.com", ":", &host, &p, &q);
+        ASSERT(s && !*s, s);
+        ASSERT(!p && !q);
+        s = libtext::read("example.com 443 https", " ", &host, &p, &q);
+        ASSERT(s && !*s, s);
+        ASSERT(p && *p == 443);
+        ASSERT(q && *q == "https");
+        s = libtext::read("example.com 99999", " ", &host, &p, &q);
+        ASSERT(!s);
+        ASSERT(p && *p == 443);
+        // A reused separator resets the optional of a missing last field.
+        memcpy(line, "example.com:", 13);
+        s = libtext::read(line, colon, &host, &p);
+        ASSERT(s && !*s, s);
+        ASSERT(p && *p == 443);
+        memcpy(line, "example.com", 12);
+        s = libtext::read(line, colon, &host, &p);
+        ASSERT(s && !*s, s);
+        ASSERT(!p);
+#endif
+        break;
+    }
+    case 22: {
+        // The remaining fields of a line.
+        std::string ip;
+        std::vector<std::string> names;
+        s = libtext::read("127.0.0.1 localhost localhost.localdomain lh\nx",
+                          " ", &ip, &names);
+        ASSERT(s && *s == '\n', s);
+        ASSERT(names.size() == 3, names.size());
+        ASSERT(names[0] == "localhost" && names[2] == "lh", names[0]);
+        // No more fields.
+        s = libtext::read("::1", " ", &ip, &names);
+        ASSERT(s && !*s, s);
+        ASSERT(names.empty(), names.size());
+
+        std::string cpu;
+        std::vector<uint64_t> counters;
+        s = libtext::read("cpu  10132153 290696 3084719 46828483 16683 0 25195"
+                          " 0 0 0", " ", &cpu, &counters);
+        ASSERT(s && !*s, s);
+        ASSERT(cpu == "cpu", cpu);
+        ASSERT(counters.size() == 10, counters.size());
+        ASSERT(counters[0] == 10132153 && counters[6] == 25195, counters[0]);
+
+        // Many fields are read in multiple batches.
+        std::string line;
+        for (int k = 0; k < 100; ++k)
+            line += tos(k * 1000003) + ":";
+        line += "-1";
+        std::vector<int64_t> v;
+        s = libtext::read(line.c_str(), ":", &v);
+        ASSERT(s && !*s, s);
+        ASSERT(v.size() == 101, v.size());
+        ASSERT(v[99] == 99 * 1000003 && v[100] == -1, v[99], v[100]);
+
+        // A malformed field fails the read and keeps the fields before it.
+        s = libtext::read("1:2:x:4", ":", &v);
+        ASSERT(!s);
+        ASSERT(v.size() == 2 && v[1] == 2, v.size());
+        ASSERT(!libtext::read("1:2:", ":", &v));
+        ASSERT(!libtext::read("1::2", ":", &v));
+
+        // A fixed number of fields.
+        std::array<int32_t, 3> a;
+        s = libtext::read("1, 2, 3, 4", ", ", &a);
+        ASSERT(s && *s == '4', s);
+        ASSERT(a[0] == 1 && a[1] == 2 && a[2] == 3, a[0], a[1], a[2]);
+        s = libtext::read("1, 2", ", ", &a);
+        ASSERT(!s);
+        std::array<float, 2> f;
+        s = libtext::read("1.5 -2", " ", &f);
+        ASSERT(s && !*s, s);
+        ASSERT(f[0] == 1.5f && f[1] == -2.0f, f[0], f[1]);
+
+        // A caller array.
+        uint16_t u[4];
+        size_t n = 7;
+        s = libtext::read("1 2 3 4 5", " ", libtext::span(u, 4, &n));
+        ASSERT(s && *s == '5', s);
+        ASSERT(n == 4 && u[3] == 4, n, u[3]);
+        s = libtext::read("", " ", libtext::span(u, 4, &n));
+        ASSERT(s && !*s, s);
+        ASSERT(n == 0, n);
+
+        // The batch conversion agrees with the conversion of a single field
+        // on octal, hexadecimal, signed, long and out of range numbers.
+        const char* numbers[] = {
+            "0", "-0", "+7", "010", "0x1f", "0X1F", "00", "-128", "127",
+            "128", "-129", "255", "256", "-1", "32767", "-32768", "65535",
+            "65536", "2147483647", "-2147483648", "4294967295", "4294967296",
+            "9223372036854775807", "-9223372036854775808",
+            "9223372036854775808", "18446744073709551615",
+            "18446744073709551616", "1234567890123456789",
+            "00000000000000000001", "12345678", "123456789", "1x", "- 1",
+            "+-1", 0
+        };
+        for (const char** p = numbers; *p; ++p) {
+            batch<int8_t>(*p);
+            batch<int16_t>(*p);
+            batch<int32_t>(*p);
+            batch<int64_t>(*p);
+            batch<uint8_t>(*p);
+            batch<uint16_t>(*p);
+            batch<uint32_t>(*p);
+            batch<uint64_t>(*p);
+        }
+        srand(1);
+        for (int k = 0; k < 10000; ++k) {
+            std::string x = tos((int64_t) rand() * rand() * (rand() % 3 - 1));
+            batch<int64_t>(x.c_str());
+            batch<int32_t>(x.c_str());
+            batch<uint32_t>(x.c_str());
+        }
+        break;
+    }
+    case 23: {
+        // A field, which is a list.
+        const char* line = "/dev/sda1 / ext4 rw,noatime,errors=remount-ro 0 1";
+        std::string spec, file, type;
+        std::vector<std::string> opts;
+        int32_t freq, passno;
+        s = libtext::read(line, " ", &spec, &file, &type,
+                          libtext::list(&opts, ","), &freq, &passno);
+        ASSERT(s && !*s, s);
+        ASSERT(opts.size() == 3, opts.size());
+        ASSERT(opts[0] == "rw" && opts[2] == "errors=remount-ro", opts[0]);
+        ASSERT(passno == 1, passno);
+
+        std::vector<std::pair<string_view_t, string_view_t> > kv;
+        s = libtext::read(line, " ", 0, 0, 0, libtext::list(&kv, ","));
+        ASSERT(s && *s == '0', s);
+        ASSERT(kv.size() == 3, kv.size());
+        ASSERT(kv[0].first == "rw" && kv[0].second.empty(), kv[0].first);
+        ASSERT(kv[2].first == "errors", kv[2].first);
+        ASSERT(kv[2].second == "remount-ro", kv[2].second);
+#ifdef have_string_view
+        // The items refer to the input.
+        ASSERT(kv[1].first.data() == strstr(line, "noatime"));
+#endif
+
+        // Multi character separators and space around items.
+        std::vector<std::pair<std::string, std::string> > skv;
+        s = libtext::read("x| a := 1 ;; b:=2;;c |y", "|",
+                          0, libtext::list(&skv, ";;", ":="), &file);
+        ASSERT(s && !*s, s);
+        ASSERT(skv.size() == 3, skv.size());
+        ASSERT(skv[0].first == "a " && skv[0].second == " 1", skv[0].first);
+        ASSERT(skv[1].first == "b" && skv[1].second == "2", skv[1].first);
+        ASSERT(skv[2].first == "c" && skv[2].second.empty(), skv[2].first);
+        ASSERT(file == "y", file);
+
+        // A single item.
+        s = libtext::read("rw", " ", libtext::list(&opts, ","));
+        ASSERT(s && !*s, s);
+        ASSERT(opts.size() == 1 && opts[0] == "rw", opts.size());
+
+        // Malformed lists.
+        ASSERT(!libtext::read("rw,,ro", " ", libtext::list(&opts, ",")));
+        ASSERT(!libtext::read("rw,", " ", libtext::list(&opts, ",")));
+        ASSERT(!libtext::read(",rw", " ", libtext::list(&opts, ",")));
+        ASSERT(!libtext::read("rw, 1", " ", libtext::list(&opts, ","), 0));
+        ASSERT(!libtext::read("", " ", libtext::list(&opts, ",")));
+        ASSERT(!libtext::read("a,=1", " ", libtext::list(&kv, ",")));
+        break;
+    }
+    case 24: {
+        // Key/value pairs.
+        const char* meminfo =
+            "MemTotal:       16318216 kB\n"
+            "MemFree:         1409000 kB\n"
+            "MemAvailable:   10431480 kB\n"
+            "Buffers:          785620 kB\n"
+            "\n"
+            "HugePages_Total:       0\n";
+        uint64_t total = 0, free = 0, avail = 0, huge = 7;
+        libtext::keyset mem(":");
+        mem.bind("MemTotal", &total).bind("MemFree", &free)
+            .bind("MemAvailable", &avail).bind("HugePages_Total", &huge);
+        s = libtext::read(meminfo, mem);
+        ASSERT(s && !*s, s);
+        ASSERT(total == 16318216 && free == 1409000, total, free);
+        ASSERT(avail == 10431480 && huge == 0, avail, huge);
+        ASSERT(mem.matched() == 4 && mem.unknown() == 1, mem.matched(),
+                                                         mem.unknown());
+
+        // memory.stat.
+        int64_t anon = 0;
+        std::string file;
+        libtext::keyset stat(" ");
+        stat.bind("anon", &anon).bind("file", &file);
+        s = libtext::read("anon 4096\nfile 8192\nkernel 12\n", stat);
+        ASSERT(s && !*s, s);
+        ASSERT(anon == 4096 && file == "8192", anon, file);
+        ASSERT(stat.unknown() == 1, stat.unknown());
+        // Rebind a key.
+        int64_t file2 = 0;
+        stat.bind("file", &file2);
+        s = libtext::read("file 1", stat);
+        ASSERT(s && !*s, s);
+        ASSERT(file2 == 1, file2);
+
+        // logfmt.
+        std::string level, path;
+        uint16_t status = 0;
+        double duration = 0;
+        libtext::keyset logfmt("=", " ");
+        logfmt.bind("level", &level).bind("status", &status)
+            .bind("path", &path).bind("duration", &duration);
+        s = libtext::read("level=info path=/a status=200 user=x duration=0.5"
+                          "\nlevel=warn", logfmt);
+        ASSERT(s && *s == '\n', s);
+        ASSERT(level == "info" && path == "/a", level, path);
+        ASSERT(status == 200 && duration == 0.5, status, duration);
+        ASSERT(logfmt.matched() == 4 && logfmt.unknown() == 1,
+               logfmt.matched(), logfmt.unknown());
+        s = libtext::read(s + 1, logfmt);
+        ASSERT(s && !*s, s);
+        ASSERT(level == "warn", level);
+
+        // Quoted values.
+        std::string msg;
+        int32_t x = 0;
+        libtext::keyset quoted("=", " ");
+        quoted.bind("msg", &msg).bind("x", &x);
+        s = libtext::read("lvl=3 msg=\"hello world\" x=1", quoted);
+        ASSERT(s && !*s, s);
+        ASSERT(msg == "hello world", msg);
+        ASSERT(x == 1, x);
+        ASSERT(quoted.matched() == 2 && quoted.unknown() == 1,
+               quoted.matched(), quoted.unknown());
+        s = libtext::read("msg=\"say \\\"hi\\\" \\\\\" a=\"b c\" x=\" 2 \"",
+                          quoted);
+        ASSERT(s && !*s, s);
+        ASSERT(msg == "say \"hi\" \\", msg);
+        ASSERT(x == 2, x);
+        ASSERT(quoted.unknown() == 1, quoted.unknown());
+#ifdef have_string_view
+        std::string_view view, view2;
+        quoted.bind("msg", &view).bind("m2", &view2);
+        s = libtext::read("msg=\"a b\" m2=\"c d\"", quoted);
+        ASSERT(s && !*s, s);
+        ASSERT(view == "a b" && view2 == "c d", view, view2);
+#endif
+        // No closing quote, a malformed quoted value, no separator after
+        // the quote.
+        ASSERT(!libtext::read("msg=\"hello world x=1", quoted));
+        ASSERT(!libtext::read("x=\"1 2\"", quoted));
+        ASSERT(!libtext::read("msg=\"a\"b x=1", quoted));
+
+        // Malformed pairs.
+        ASSERT(!libtext::read("status=x", logfmt));
+        ASSERT(!libtext::read("status=70000", logfmt));
+        ASSERT(!libtext::read("status 200", logfmt));
+        ASSERT(!libtext::read("level=info junk status=200", logfmt));
+        ASSERT(!libtext::read("=info", logfmt));
+        ASSERT(!libtext::read("MemTotal 5\n", mem));
+
+        // Many keys.
+        std::vector<uint32_t> values(300);
+        std::string input;
+        libtext::keyset many("=", ",");
+        for (size_t k = 0; k < values.size(); ++k) {
+            const std::string key = "key" + tos(k * 7);
+            many.bind(key.c_str(), &values[k]);
+            input += (k ? "," : "") + key + "=" + tos(k);
+        }
+        s = libtext::read((input + ",key1=1").c_str(), many);
+        ASSERT(s && !*s, s);
+        ASSERT(many.matched() == values.size(), many.matched());
+        ASSERT(many.unknown() == 1, many.unknown());
+        for (size_t k = 0; k < values.size(); ++k)
+            ASSERT(values[k] == k, values[k], k);
+        break;
+    }
+    case 25: {
+        // Escapes.
+        const char* line = "/dev/sdb1 /mnt/my\\040disk\\011x ext4";
+        std::string spec, file, type;
+        s = libtext::read(line, " ", libtext::unescape(&spec),
+                          libtext::unescape(&file), &type);
+        ASSERT(s && !*s, s);
+        ASSERT(spec == "/dev/sdb1", spec);
+        ASSERT(file == "/mnt/my disk\tx", file);
+        ASSERT(type == "ext4", type);
+
+        s = libtext::read("\\\\\\'\\\"\\a\\b\\f\\n\\r\\t\\v", " ",
+                          libtext::unescape(&file));
+        ASSERT(s && !*s, s);
+        ASSERT(file == "\\'\"\a\b\f\n\r\t\v", file);
+        // At most 3 octal digits.
+        s = libtext::read("\\1234\\0\\12x\\377", " ",
+                          libtext::unescape(&file));
+        ASSERT(s && !*s, s);
+        ASSERT(file == std::string("S4\0\nx\377", 6), file);
+
+        // Malformed escapes keep the result intact.
+        file = "x";
+        ASSERT(!libtext::read("a\\x", " ", libtext::unescape(&file)));
+        ASSERT(!libtext::read("a\\", " ", libtext::unescape(&file)));
+        ASSERT(!libtext::read("a\\400", " ", libtext::unescape(&file)));
+        ASSERT(!libtext::read("a\\ b", " ", libtext::unescape(&file)));
+        ASSERT(!libtext::read("", " ", libtext::unescape(&file)));
+        ASSERT(file == "x", file);
+
+        // Empty fields.
+        const libtext::empty_fields e(":");
+        s = libtext::read("a::b\\072c", e, libtext::unescape(&spec),
+                          libtext::unescape(&file), libtext::unescape(&type));
+        ASSERT(s && !*s, s);
+        ASSERT(spec == "a" && file.empty() && type == "b:c", spec, file,
+                                                              type);
+#ifdef have_string_view
+        // A field without escapes refers to the input. A decoded field
+        // refers to the buffer.
+        std::string_view sv, sv2;
+        std::string buf = "x", buf2;
+        s = libtext::read(line, " ", libtext::unescape(&sv, &buf),
+                          libtext::unescape(&sv2, &buf2));
+        ASSERT(s && *s == 'e', s);
+        ASSERT(sv == "/dev/sdb1" && sv.data() == line, sv);
+        ASSERT(buf == "x", buf);
+        ASSERT(sv2 == "/mnt/my disk\tx" && sv2.data() == buf2.data(), sv2);
+#endif
+        break;
+    }
+    case 26: {
+        // Integers of an explicit base.
+        uint32_t addr = 0;
+        uint16_t port = 0;
+        s = libtext::read("0100007F:0035", ":", libtext::hex(&addr),
+                          libtext::hex(&port));
+        ASSERT(s && !*s, s);
+        ASSERT(addr == 0x0100007f && port == 53, addr, port);
+        int32_t i32 = 0;
+        s = libtext::read("010 08 -0755 +12", " ", libtext::dec(&i32),
+                          libtext::dec(&port), libtext::oct(&i32), 0);
+        ASSERT(s && !*s, s);
+        ASSERT(port == 8 && i32 == -0755, port, i32);
+        s = libtext::read("010", " ", libtext::dec(&i32));
+        ASSERT(s && i32 == 10, i32);
+
+        uint64_t u64 = 0;
+        s = libtext::read("00000000DeadBeefCafeF00d", " ", libtext::hex(&u64));
+        ASSERT(s && u64 == 0xdeadbeefcafef00dull, u64);
+        s = libtext::read("ffffffffffffffff", " ", libtext::hex(&u64));
+        ASSERT(s && u64 == 0xffffffffffffffffull, u64);
+        s = libtext::read("18446744073709551615", " ", libtext::dec(&u64));
+        ASSERT(s && u64 == 0xffffffffffffffffull, u64);
+        s = libtext::read("1777777777777777777777", " ", libtext::oct(&u64));
+        ASSERT(s && u64 == 0xffffffffffffffffull, u64);
+        int64_t i64 = 0;
+        s = libtext::read("-8000000000000000", " ", libtext::hex(&i64));
+        ASSERT(s && i64 == std::numeric_limits<int64_t>::min(), i64);
+        s = libtext::read("7fffffffffffffff", " ", libtext::hex(&i64));
+        ASSERT(s && i64 == std::numeric_limits<int64_t>::max(), i64);
+        int8_t i8 = 0;
+        s = libtext::read("-80 7f", " ", libtext::hex(&i8), 0);
+        ASSERT(s && i8 == -128, i8);
+
+        // Agree with strtoull on all lengths of hexadecimal numbers.
+        const char* digits = "0123456789abcdefABCDEF";
+        srand(2);
+        for (int k = 0; k < 10000; ++k) {
+            std::string x;
+            for (int len = 1 + rand() % 16; len; --len)
+                x += digits[rand() % 22];
+            s = libtext::read(x.c_str(), " ", libtext::hex(&u64));
+            ASSERT(s && !*s, s);
+            ASSERT(u64 == strtoull(x.c_str(), 0, 16), u64, x);
+        }
+
+        // Overflow and numbers without digits keep the result intact.
+        port = 7;
+        ASSERT(!libtext::read("10000", " ", libtext::hex(&port)));
+        ASSERT(!libtext::read("-1", " ", libtext::hex(&port)));
+        ASSERT(!libtext::read("8", " ", libtext::oct(&port)));
+        ASSERT(!libtext::read("a", " ", libtext::dec(&port)));
+        ASSERT(!libtext::read("", " ", libtext::dec(&port)));
+        ASSERT(!libtext::read("-", " ", libtext::dec(&port)));
+        ASSERT(!libtext::read("80", " ", libtext::hex(&i8)));
+        ASSERT(!libtext::read("-81", " ", libtext::hex(&i8)));
+        ASSERT(!libtext::read("10000000000000000", " ", libtext::hex(&u64)));
+        ASSERT(!libtext::read("18446744073709551616", " ",
+                              libtext::dec(&u64)));
+        ASSERT(!libtext::read("2000000000000000000000", " ",
+                              libtext::oct(&u64)));
+        ASSERT(port == 7, port);
+        ASSERT(!libtext::read("1g", " ", libtext::hex(&port)));
+        ASSERT(!libtext::read("0x10", " ", libtext::hex(&port)));
+
+        // Empty fields keep the default value.
+        port = 7;
+        s = libtext::read("1f::", libtext::empty_fields(":"),
+                          libtext::hex(&addr), libtext::hex(&port),
+                          libtext::hex(&port));
+        ASSERT(s && !*s, s);
+        ASSERT(addr == 31 && port == 7, addr, port);
+        break;
+    }
+    case 27: {
+        // Fixed point decimal numbers.
+        std::string ticker;
+        libtext::decimal<4> price;
+        libtext::decimal<0> qty;
+        s = libtext::read("IBM | 142.3575 | 300", "|", &ticker, &price, &qty);
+        ASSERT(s && !*s, s);
+        ASSERT(price.mantissa == 1423575, price.mantissa);
+        ASSERT(qty.mantissa == 300, qty.mantissa);
+
+        libtext::decimal<2> d2;
+        const char* in[][2] = {
+            {"0", "0"}, {"-0", "0"}, {"1", "100"}, {"+1.5", "150"},
+            {"-1.5", "-150"}, {".5", "50"}, {"5.", "500"}, {"007.10", "710"},
+            {"1.004", "100"}, {"1.005", "100"}, {"1.0051", "101"},
+            {"1.015", "102"}, {"1.006", "101"}, {"-1.005", "-100"},
+            {"-1.015", "-102"}, {"0.0050000000000000000001", "1"},
+            {"92233720368547758.07", "9223372036854775807"},
+            {"-92233720368547758.08", "-9223372036854775808"},
+        };
+        for (size_t k = 0; k < sizeof in / sizeof in[0]; ++k) {
+            d2.mantissa = 7;
+            s = libtext::read(in[k][0], " ", &d2);
+            ASSERT(s && !*s, s, in[k][0]);
+            ASSERT(tos(d2.mantissa) == in[k][1], d2.mantissa, in[k][0]);
+        }
+        libtext::decimal<18> d18;
+        s = libtext::read("-9.223372036854775808", " ", &d18);
+        ASSERT(s && d18.mantissa == std::numeric_limits<int64_t>::min(),
+               d18.mantissa);
+        s = libtext::read("0.0000000000000000015", " ", &d18);
+        ASSERT(s && d18.mantissa == 2, d18.mantissa);
+
+        // Overflow and malformed numbers keep the result intact.
+        d2.mantissa = 7;
+        ASSERT(!libtext::read("92233720368547758.08", " ", &d2));
+        ASSERT(!libtext::read("92233720368547758.075", " ", &d2));
+        ASSERT(!libtext::read("-92233720368547758.09", " ", &d2));
+        ASSERT(!libtext::read("100000000000000000000", " ", &d2));
+        ASSERT(!libtext::read("9.3", " ", &d18));
+        ASSERT(!libtext::read(".", " ", &d2));
+        ASSERT(!libtext::read("-", " ", &d2));
+        ASSERT(!libtext::read("", " ", &d2));
+        ASSERT(!libtext::read("x", " ", &d2));
+        ASSERT(d2.mantissa == 7, d2.mantissa);
+        ASSERT(!libtext::read("1e5", " ", &d2));
+        ASSERT(!libtext::read("1.2.3", " ", &d2));
+
+        // Empty fields keep the default value.
+        d2.mantissa = 7;
+        s = libtext::read("1.25,", libtext::empty_fields(","), &price, &d2);
+        ASSERT(s && !*s, s);
+        ASSERT(price.mantissa == 12500 && d2.mantissa == 7, d2.mantissa);
+        break;
+    }
+    case 28: {
+        // Timestamps.
+        struct timespec ts;
+        s = libtext::read("1791640536.25", " ", &ts);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == 1791640536 && ts.tv_nsec == 250000000, ts.tv_sec,
+                                                                  ts.tv_nsec);
+        s = libtext::read("-1.5", " ", &ts);
+        ASSERT(s && ts.tv_sec == -2 && ts.tv_nsec == 500000000, ts.tv_sec,
+                                                                ts.tv_nsec);
+        struct tm tm = {};
+        tm.tm_year = 2026 - 1900;
+        tm.tm_mon = 9;
+        tm.tm_mday = 10;
+        tm.tm_hour = 13;
+        tm.tm_min = 55;
+        tm.tm_sec = 36;
+        const time_t t = timegm(&tm);
+        s = libtext::read("2026-10-10T13:55:36Z", " ", &ts);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t && ts.tv_nsec == 0, ts.tv_sec, t);
+        s = libtext::read("2026-10-10t15:55:36.123456789123+02:00", " ", &ts);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t && ts.tv_nsec == 123456789, ts.tv_sec,
+                                                          ts.tv_nsec);
+        s = libtext::read("2026-10-10T08:55:36,5-0500", " ", &ts);
+        ASSERT(s && ts.tv_sec == t && ts.tv_nsec == 500000000, ts.tv_sec);
+        std::string method;
+        s = libtext::read("2026-10-10 13:55:36 GET", " ", &ts, &method);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t && method == "GET", ts.tv_sec, method);
+        s = libtext::read("2026-10-10 GET", " ", &ts, &method);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t - 13 * 3600 - 55 * 60 - 36, ts.tv_sec);
+        s = libtext::read("[10/Oct/2026:13:55:36 +0000] GET", " ", &ts,
+                          &method);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t && ts.tv_nsec == 0, ts.tv_sec);
+        s = libtext::read("10/Oct/2026:06:55:36 -0700", " ", &ts);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t, ts.tv_sec);
+        // The seconds are optional.
+        struct timespec ts2;
+        s = libtext::read("2026-10-10T13:55Z 2026-10-10 15:55+02:00", " ",
+                          &ts, &ts2);
+        ASSERT(s && !*s, s);
+        ASSERT(ts.tv_sec == t - 36 && ts.tv_nsec == 0, ts.tv_sec, t);
+        ASSERT(ts2.tv_sec == t - 36 && ts2.tv_nsec == 0, ts2.tv_sec, t);
+        // A fraction follows the seconds only.
+        ASSERT(!libtext::read("2026-10-10T13:55.5Z", " ", &ts2));
+        s = libtext::read("1969-12-31T23:59:59Z", " ", &ts);
+        ASSERT(s && ts.tv_sec == -1, ts.tv_sec);
+        s = libtext::read("2024-02-29T00:00:00Z", " ", &ts);
+        ASSERT(s && ts.tv_sec == 1709164800, ts.tv_sec);
+
+        // Agree with timegm.
+        srand(3);
+        for (int k = 0; k < 10000; ++k) {
+            struct tm r = {};
+            r.tm_year = rand() % 400 - 100;
+            r.tm_mon = rand() % 12;
+            r.tm_mday = 1 + rand() % 28;
+            r.tm_hour = rand() % 24;
+            r.tm_min = rand() % 60;
+            r.tm_sec = rand() % 60;
+            char buf[64];
+            strftime(buf, sizeof buf, "%Y-%m-%dT%H:%M:%S", &r);
+            s = libtext::read(buf, " ", &ts);
+            ASSERT(s && !*s, s);
+            ASSERT(ts.tv_sec == timegm(&r), ts.tv_sec, buf);
+        }
+
+        // Malformed timestamps keep the result intact.
+        ts.tv_sec = 7;
+        ASSERT(!libtext::read("2026-02-29", " ", &ts));
+        ASSERT(!libtext::read("2026-13-01", " ", &ts));
+        ASSERT(!libtext::read("2026-10-10T24:00:00", " ", &ts));
+        ASSERT(!libtext::read("2026-10-10T13", " ", &ts));
+        ASSERT(!libtext::read("2026-10-10T13:55:3", " ", &ts));
+        ASSERT(!libtext::read("2026-10-10T13:5Z", " ", &ts));
+        ASSERT(!libtext::read("2026-10-10T13:55:36+2", " ", &ts));
+        ASSERT(!libtext::read("10/Foo/2026:13:55:36 +0000", " ", &ts));
+        ASSERT(!libtext::read("[10/Oct/2026:13:55:36 +0000", " ", &ts));
+        ASSERT(!libtext::read("1.", " ", &ts));
+        ASSERT(!libtext::read("x", " ", &ts));
+        ASSERT(!libtext::read("", " ", &ts));
+        ASSERT(!libtext::read("[", " ", &ts));
+        ASSERT(!libtext::read("99999999999999999999", " ", &ts));
+        ASSERT(ts.tv_sec == 7, ts.tv_sec);
+        ASSERT(!libtext::read("1/", " ", &ts));
+
+        // std::chrono.
+        std::chrono::system_clock::time_point tp;
+        s = libtext::read("1.5", " ", &tp);
+        ASSERT(s && !*s, s);
+        ASSERT(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    tp.time_since_epoch()).count() == 1500);
+        std::chrono::time_point<std::chrono::system_clock,
+                                std::chrono::seconds> tps;
+        s = libtext::read("2026-10-10T13:55:36.9Z,",
+                          libtext::empty_fields(","), &tps, &tp);
+        ASSERT(s && !*s, s);
+        ASSERT(tps.time_since_epoch().count() == t);
+        ASSERT(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    tp.time_since_epoch()).count() == 1500);
+        break;
+    }
+    case 29: {
+        // Addresses. Agree with inet_pton.
+        const char* v4[] = {
+            "0.0.0.0", "127.0.0.1", "255.255.255.255", "10.0.200.1",
+            "256.0.0.1", "1.2.3", "1.2.3.4.5", "01.2.3.4", "1..2.3", "a.b.c.d",
+            "1.2.3.1000", "", ".1.2.3",
+        };
+        for (size_t k = 0; k < sizeof v4 / sizeof v4[0]; ++k) {
+            struct in_addr a = {}, b = {};
+            const int valid = inet_pton(AF_INET, v4[k], &b);
+            s = libtext::read(v4[k], " ", &a);
+            ASSERT(!!s == valid, s, v4[k]);
+            ASSERT(!valid || !memcmp(&a, &b, sizeof a), v4[k]);
+        }
+        const char* v6[] = {
+            "::", "::1", "1::", "fe80::1", "2001:db8::8a2e:370:7334",
+            "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7::", "::2:3:4:5:6:7:8",
+            "::ffff:127.0.0.1", "1:2:3:4:5:6:1.2.3.4", "ABCD:ef01::",
+            "1:2:3:4:5:6:7:8:9", "1::2::3", "12345::", ":1::", "1:", "::g",
+            "1:2:3:4:5:6:7", "::1.2.3", "1:2:3:4:5:6:7:1.2.3.4", "",
+            "1:2:3:4:5:6:7:8::",
+        };
+        for (size_t k = 0; k < sizeof v6 / sizeof v6[0]; ++k) {
+            struct in6_addr a = {}, b = {};
+            const int valid = inet_pton(AF_INET6, v6[k], &b);
+            s = libtext::read(v6[k], " ", &a);
+            ASSERT(!!s == valid, s, v6[k]);
+            ASSERT(!valid || !memcmp(&a, &b, sizeof a), v6[k]);
+        }
+
+        // Separators.
+        struct in_addr a4;
+        struct in6_addr a6, loopback = IN6ADDR_LOOPBACK_INIT;
+        uint16_t port = 0;
+        s = libtext::read("127.0.0.1:80", ":", &a4, &port);
+        ASSERT(s && !*s, s);
+        ASSERT(a4.s_addr == htonl(INADDR_LOOPBACK) && port == 80, port);
+        s = libtext::read("[::1]:443", ":", &a6, &port);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(&a6, &loopback, sizeof a6) && port == 443, port);
+        ASSERT(!libtext::read("::1:443", ":", &a6, &port));
+        s = libtext::read("::1 fe80::1", " ", &a6, &a6);
+        ASSERT(s && !*s, s);
+        s = libtext::read("::1, 1.2.3.4", ",", &a6, &a4);
+        ASSERT(s && !*s, s);
+        ASSERT(!libtext::read("[::1", " ", &a6));
+
+        // Addresses and ports.
+        struct sockaddr_storage ss;
+        s = libtext::read("127.0.0.1:80 [::1]:443", " ", &ss, 0);
+        ASSERT(s && !*s, s);
+        const struct sockaddr_in* sin = (const struct sockaddr_in*) &ss;
+        ASSERT(ss.ss_family == AF_INET, ss.ss_family);
+        ASSERT(sin->sin_port == htons(80), ntohs(sin->sin_port));
+        ASSERT(sin->sin_addr.s_addr == htonl(INADDR_LOOPBACK));
+        s = libtext::read("[::1]:443", " ", &ss);
+        ASSERT(s && !*s, s);
+        const struct sockaddr_in6* sin6 = (const struct sockaddr_in6*) &ss;
+        ASSERT(ss.ss_family == AF_INET6, ss.ss_family);
+        ASSERT(sin6->sin6_port == htons(443), ntohs(sin6->sin6_port));
+        ASSERT(!memcmp(&sin6->sin6_addr, &loopback, sizeof loopback));
+        s = libtext::read("fe80::1 10.0.0.1", " ", &ss, &ss);
+        ASSERT(s && !*s, s);
+        ASSERT(ss.ss_family == AF_INET && sin->sin_port == 0, ss.ss_family);
+        ASSERT(!libtext::read("1.2.3.4:", " ", &ss));
+        ASSERT(!libtext::read("1.2.3.4:65536", " ", &ss));
+        ASSERT(!libtext::read("1.2.3.4:080", " ", &ss));
+        ASSERT(!libtext::read("[1.2.3.4]:80", " ", &ss));
+        ASSERT(!libtext::read("example.com:80", " ", &ss));
+        break;
+    }
+    case 30: {
+        // Names of a vocabulary.
+        enum state {unknown_state, running, sleeping, disk_sleep, zombie};
+        const libtext::symbol names[] = {
+            {"R", running}, {"S", sleeping}, {"D", disk_sleep}, {"Z", zombie},
+        };
+        const libtext::symbols states(names);
+        int32_t pid = 0;
+        std::string comm;
+        state st = unknown_state;
+        s = libtext::read("42 (bash) S 1", " ", &pid, &comm,
+                          libtext::one_of(&st, states), 0);
+        ASSERT(s && !*s, s);
+        ASSERT(st == sleeping, st);
+        ASSERT(!libtext::read("Q", " ", libtext::one_of(&st, states)));
+        ASSERT(!libtext::read("RS", " ", libtext::one_of(&st, states)));
+        ASSERT(!libtext::read("", " ", libtext::one_of(&st, states)));
+        ASSERT(st == sleeping, st);
+        s = libtext::read("D ,", libtext::empty_fields(","),
+                          libtext::one_of(&st, states),
+                          libtext::one_of(&st, states));
+        ASSERT(s && !*s, s);
+        ASSERT(st == disk_sleep, st);
+
+        // Flags.
+        enum {ro = 1, rw = 2, noatime = 4, nosuid = 8, nodev = 16};
+        const libtext::symbol optnames[] = {
+            {"ro", ro}, {"rw", rw}, {"noatime", noatime}, {"nosuid", nosuid},
+            {"nodev", nodev}, {"rw", rw | 32},
+        };
+        const libtext::symbols opts(optnames);
+        unsigned mask = 0;
+        s = libtext::read("/dev/sda1 / ext4 rw,noatime,nosuid 0 1", " ", 0,
+                          0, 0, libtext::flags(&mask, opts), 0, 0);
+        ASSERT(s && !*s, s);
+        ASSERT(mask == (rw | 32 | noatime | nosuid), mask);
+        mask = 7;
+        ASSERT(!libtext::read("rw,sync", " ", libtext::flags(&mask, opts)));
+        ASSERT(!libtext::read("rw,,ro", " ", libtext::flags(&mask, opts)));
+        ASSERT(!libtext::read("rw,", " ", libtext::flags(&mask, opts)));
+        ASSERT(mask == 7, mask);
+        size_t unknown = 0;
+        s = libtext::read("errors=remount-ro;ro;sync", " ",
+                          libtext::flags(&mask, opts, ";", &unknown));
+        ASSERT(s && !*s, s);
+        ASSERT(mask == ro && unknown == 2, mask, unknown);
+        // An empty field assigns nothing.
+        s = libtext::read("rw,", libtext::empty_fields(","), 0,
+                          libtext::flags(&mask, opts));
+        ASSERT(s && !*s, s);
+        ASSERT(mask == ro, mask);
+
+        // A large vocabulary.
+        std::vector<std::string> words;
+        std::vector<libtext::symbol> many;
+        for (int k = 0; k < 1000; ++k)
+            words.push_back("word" + tos(k));
+        for (int k = 0; k < 1000; ++k) {
+            const libtext::symbol sym = {words[k].c_str(), k * 3};
+            many.push_back(sym);
+        }
+        const libtext::symbols big(many.data(), many.size());
+        for (int k = 0; k < 1000; ++k) {
+            int64_t v = -1;
+            s = libtext::read(words[k].c_str(), " ", libtext::one_of(&v, big));
+            ASSERT(s && v == k * 3, v, k);
+        }
+        ASSERT(!libtext::read("word1000", " ", libtext::one_of(&pid, big)));
+        break;
+    }
+    case 31: {
+        // A type of the user.
+        market::isin id, id2;
+        libtext::decimal<2> price;
+        s = libtext::read("US0378331005 \t 227.52", " ", &id, &price);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(id.code, "US0378331005", 12));
+        ASSERT(price.mantissa == 22752, price.mantissa);
+        s = libtext::read("AAPL | US0378331005 | 227.52", "|", 0, &id, 0);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(id.code, "US0378331005", 12));
+
+        // The same validation as for the types of libtext.
+        memcpy(id.code, "XX0000000000", 12);
+        ASSERT(!libtext::read("US037833100", " ", &id));
+        ASSERT(!libtext::read("US03783310-5", " ", &id));
+        ASSERT(!libtext::read("", " ", &id));
+        ASSERT(!memcmp(id.code, "XX0000000000", 12));
+        ASSERT(!libtext::read("US0378331005,", ",", &id));
+        ASSERT(!libtext::read("US0378331005,,US0378331005", ",", &id, &id));
+        ASSERT(!libtext::read("US0378331005 US0378331005", " ", &id, &id,
+                              &id));
+        s = libtext::read("US0378331005 x", " ", &id);
+        ASSERT(s && *s == 'x', s);
+
+        // Empty fields keep the default value.
+        memcpy(id2.code, "XX0000000000", 12);
+        s = libtext::read("US0378331005,", libtext::empty_fields(","), &id,
+                          &id2);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(id2.code, "XX0000000000", 12));
+
+        // Optional and all remaining fields.
+        std::vector<market::isin> ids;
+        s = libtext::read("US0378331005 US5949181045", " ", &ids);
+        ASSERT(s && !*s, s);
+        ASSERT(ids.size() == 2 && !memcmp(ids[1].code, "US5949181045", 12),
+               ids.size());
+        break;
+    }
+    case 32: {
+#ifdef have_int128
+        typedef unsigned __int128 u128;
+        u128 u = 7;
+        __int128 i = 7;
+        const u128 umax = ~(u128) 0;
+
+        // Every power of 2, the number before it and its negation, in all
+        // three bases.
+        for (int k = 0; k < 128; ++k) {
+            const u128 v = (u128) 1 << k;
+            const u128 w = v - 1;
+            std::string dec = tos(v) + " " + tos(w);
+            s = libtext::read(dec.c_str(), " ", &u, &i);
+            ASSERT(s && !*s, s, dec);
+            ASSERT(u == v, u, v, dec);
+            ASSERT(i == (__int128) w, i, w, dec);
+            dec = "-" + tos(w);
+            s = libtext::read(dec.c_str(), " ", &i);
+            ASSERT(s && !*s, s, dec);
+            ASSERT(i == -(__int128) w, i, w, dec);
+            std::string hex = "0x1" + std::string(k / 4, '0');
+            hex[2] = "1248"[k % 4];
+            s = libtext::read(hex.c_str(), " ", &u);
+            ASSERT(s && !*s, s, hex);
+            ASSERT(u == v, u, v, hex);
+            std::string oct = "01" + std::string(k / 3, '0');
+            oct[1] = "124"[k % 3];
+            s = libtext::read(oct.c_str(), " ", &u);
+            ASSERT(s && !*s, s, oct);
+            ASSERT(u == v, u, v, oct);
+        }
+
+        // Digits of all words.
+        s = libtext::read("0x0123456789abcdefFEDCBA9876543210 "
+                          "123456789012345678901234567890123456789", " ",
+                          &u, &i);
+        ASSERT(s && !*s, s);
+        ASSERT(u == ((u128) 0x0123456789abcdefull << 64 |
+                     0xfedcba9876543210ull), u);
+        ASSERT(i == (__int128) 12345678901234567890ull *
+                    10000000000000000000ull + 1234567890123456789ull, i);
+
+        // The largest number of each base and the smallest, which overflows.
+        s = libtext::read("0xffffffffffffffffffffffffffffffff", " ", &u);
+        ASSERT(s && !*s && u == umax, s, u);
+        const std::string oct = "03" + std::string(42, '7');
+        s = libtext::read(oct.c_str(), " ", &u);
+        ASSERT(s && !*s && u == umax, s, u);
+        u = 7;
+        ASSERT(!libtext::read("0x100000000000000000000000000000000", " ",
+                              &u));
+        ASSERT(!libtext::read(("04" + std::string(42, '0')).c_str(), " ",
+                              &u));
+        ASSERT(!libtext::read("3402823669209384634633746074317682114550",
+                              " ", &u));
+        ASSERT(u == 7, u);
+
+        // Leading zeros do not count.
+        s = libtext::read(("-" + std::string(50, '0') + "1").c_str(), " ",
+                          &i);
+        ASSERT(s && !*s && i == -1, s, i);
+        s = libtext::read(("0x" + std::string(50, '0') + "f").c_str(), " ",
+                          &u);
+        ASSERT(s && !*s && u == 15, s, u);
+
+        // The same prefixes and malformed input as for 64 bits.
+        const char* const inputs[] = {
+            "0x,1", "0x1g,1", "08,1", "0,1", "-0x10,1", "- 1,1", "+-1,1",
+            "\v1,1", "1e3,1", "x,1", "-,1", " 9223372036854775807,1",
+            "-9223372036854775808 ,1", ",1", "1,", "1"
+        };
+        for (const char* in : inputs) {
+            int64_t x = 7, y = 7;
+            i = 7;
+            __int128 j = 7;
+            const char* r = libtext::read(in, ",", &x, &y);
+            s = libtext::read(in, ",", &i, &j);
+            ASSERT(r == s, in, r, s);
+            ASSERT(i == x && j == y, in, i, x, j, y);
+        }
+
+        // Empty fields keep the default value.
+        i = 7;
+        u = 8;
+        s = libtext::read(",", libtext::empty_fields(","), &i, &u);
+        ASSERT(s && !*s, s);
+        ASSERT(i == 7 && u == 8, i, u);
+#endif
+        break;
+    }
+    case 33: {
+        // Hexadecimal digits of any length, in both cases.
+        for (size_t n = 1; n < 40; ++n) {
+            std::vector<unsigned char> bytes(n), out(n + 1, 0xaa);
+            std::string hex;
+            for (size_t k = 0; k < n; ++k) {
+                bytes[k] = (unsigned char) (k * 37 + n);
+                hex += "0123456789abcdef"[bytes[k] >> 4];
+                hex += "0123456789ABCDEF"[bytes[k] & 15];
+            }
+            const std::string line = hex + "  file";
+            std::string file;
+            s = libtext::read(line.c_str(), " ",
+                              libtext::hexbytes(out.data(), n), &file);
+            ASSERT(s && !*s, s, line);
+            ASSERT(std::equal(bytes.begin(), bytes.end(), out.begin()), line);
+            ASSERT(out[n] == 0xaa, line);
+            ASSERT("file" == file, file);
+            // A digit too few or too many.
+            out.assign(n, 0xaa);
+            const std::string less = hex.substr(1);
+            ASSERT(!libtext::read(less.c_str(), " ",
+                                  libtext::hexbytes(out.data(), n)), less);
+            ASSERT(out == std::vector<unsigned char>(n, 0xaa), less);
+            const std::string more = hex + "0";
+            ASSERT(!libtext::read(more.c_str(), " ",
+                                  libtext::hexbytes(out.data(), n)), more);
+            // Not a digit.
+            out.assign(n, 0xaa);
+            std::string bad = hex;
+            bad[n] = 'g';
+            ASSERT(!libtext::read(bad.c_str(), " ",
+                                  libtext::hexbytes(out.data(), n)), bad);
+            ASSERT(out == std::vector<unsigned char>(n, 0xaa), bad);
+        }
+
+        // A UUID.
+        unsigned char id[16] = {0};
+        const unsigned char expid[16] = {0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b,
+                                         0x12, 0xd3, 0xa4, 0x56, 0x42, 0x66,
+                                         0x14, 0x17, 0x40, 0x00};
+        s = libtext::read("123E4567-e89b-12d3-a456-426614174000,1", ",",
+                          libtext::uuid(id), 0);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(id, expid, 16));
+        ASSERT(!libtext::read("123e4567-e89b-12d3-a456-426614174000-", " ",
+                              libtext::uuid(id)));
+        memset(id, 0, sizeof id);
+        ASSERT(!libtext::read("123e4567e89b12d3a456426614174000", " ",
+                              libtext::uuid(id)));
+        ASSERT(!libtext::read("123e4567-e89b-12d3-a456-42661417400", " ",
+                              libtext::uuid(id)));
+        ASSERT(!libtext::read("123e456-7e89b-12d3-a456-426614174000", " ",
+                              libtext::uuid(id)));
+        ASSERT(!libtext::read("", " ", libtext::uuid(id)));
+        ASSERT(!memcmp(id, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 16));
+
+        // A MAC address, with colons or dashes, followed by any separator.
+        unsigned char hw[6] = {0};
+        const unsigned char exphw[6] = {0x00, 0x1a, 0x2b, 0x3c, 0x4d, 0x5e};
+        uint16_t port = 0;
+        s = libtext::read("00:1a:2b:3C:4d:5e:80", ":", libtext::mac(hw),
+                          &port);
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(hw, exphw, 6) && port == 80, port);
+        memset(hw, 0, sizeof hw);
+        s = libtext::read("eth0 00-1A-2B-3C-4D-5E", " ", 0, libtext::mac(hw));
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(hw, exphw, 6));
+        memset(hw, 0, sizeof hw);
+        ASSERT(!libtext::read("00:1a-2b:3c:4d:5e", " ", libtext::mac(hw)));
+        ASSERT(!libtext::read("00:1a:2b:3c:4d", " ", libtext::mac(hw)));
+        ASSERT(!libtext::read("00:1a:2b:3c:4d:5", " ", libtext::mac(hw)));
+        ASSERT(!libtext::read("0:1a:2b:3c:4d:5e", " ", libtext::mac(hw)));
+        ASSERT(!libtext::read("0", " ", libtext::mac(hw)));
+        ASSERT(!memcmp(hw, "\0\0\0\0\0\0", 6));
+
+        // Base64 of any length.
+        const char* const digits =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (size_t n = 1; n < 40; ++n) {
+            std::vector<unsigned char> bytes(n), out(n, 0xaa);
+            for (size_t k = 0; k < n; ++k)
+                bytes[k] = (unsigned char) (k * 97 + n * 13);
+            std::string b64;
+            for (size_t k = 0; k < n; k += 3) {
+                uint32_t v = bytes[k] << 16;
+                if (k + 1 < n)
+                    v |= bytes[k + 1] << 8;
+                if (k + 2 < n)
+                    v |= bytes[k + 2];
+                b64 += digits[v >> 18];
+                b64 += digits[v >> 12 & 63];
+                b64 += k + 1 < n ? digits[v >> 6 & 63] : '=';
+                b64 += k + 2 < n ? digits[v & 63] : '=';
+            }
+            size_t len = 0;
+            const std::string line = "payload=" + b64;
+            s = libtext::read(line.c_str(), "=", 0,
+                              libtext::base64(out.data(), n, &len));
+            ASSERT(s && !*s, s, line);
+            ASSERT(len == n, len, n, line);
+            ASSERT(out == bytes, line);
+            // The payload does not fit.
+            len = 7;
+            out.assign(n, 0xaa);
+            ASSERT(!libtext::read(b64.c_str(), " ",
+                                  libtext::base64(out.data(), n - 1, &len)),
+                   b64);
+            ASSERT(len == 7 && out[0] == 0xaa, len, b64);
+        }
+        unsigned char buf[8];
+        size_t len = 7;
+        memset(buf, 0, sizeof buf);
+        s = libtext::read("TWFu TWE= TQ==", " ",
+                          libtext::base64(buf, sizeof buf, &len),
+                          libtext::base64(buf + 3, sizeof buf - 3, &len),
+                          libtext::base64(buf + 5, sizeof buf - 5, &len));
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(buf, "ManMaM\0", 7) && len == 1, buf, len);
+        len = 7;
+        ASSERT(!libtext::read("TQ", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(!libtext::read("TQ=", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(!libtext::read("TWFuT", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(!libtext::read("TWFu===", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(!libtext::read("TW-u", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(!libtext::read("=", " ", libtext::base64(buf, 8, &len)));
+        ASSERT(len == 7, len);
+
+        // Empty fields keep the bytes intact.
+        memset(id, 0, sizeof id);
+        s = libtext::read("1,,", libtext::empty_fields(","), 0,
+                          libtext::uuid(id), libtext::base64(buf, 8, &len));
+        ASSERT(s && !*s, s);
+        ASSERT(!memcmp(id, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 16));
+        ASSERT(len == 7, len);
+        break;
+    }
+    case 34: {
+        // Sizes.
+        const struct {
+            const char* input;
+            uint64_t kilo;
+            uint64_t bytes;
+        } sizes[] = {
+            {"512", 1024, 512},
+            {"512B", 1024, 512},
+            {"4K", 1024, 4096},
+            {"4k", 1000, 4000},
+            {"4KiB", 1000, 4096},
+            {"16318216 kB", 1024, 16318216ull * 1024},
+            {"16318216 \t kB", 1000, 16318216000ull},
+            {"1.5G", 1024, 3ull << 29},
+            {"1.5GB", 1000, 1500000000},
+            {"0.1K", 1024, 102},
+            {".5M", 1024, 1 << 19},
+            {"3Ti", 1024, 3ull << 40},
+            {"2PiB", 1000, 2ull << 50},
+            {"15E", 1024, 15ull << 60},
+            {"15.99999999999999999999E", 1024, (16ull << 60) - 1},
+            {"18446744073709551615", 1024, 18446744073709551615ull},
+            {"18446744073709551615 B", 1000, 18446744073709551615ull},
+        };
+        for (const auto& t : sizes) {
+            uint64_t v = 7;
+            s = libtext::read(t.input, ",", libtext::size(&v, t.kilo));
+            ASSERT(s && !*s, s, t.input);
+            ASSERT(v == t.bytes, v, t.bytes, t.input);
+        }
+        uint64_t total = 7, free = 7;
+        s = libtext::read("MemTotal:       16318216 kB", ":", 0,
+                          libtext::size(&total));
+        ASSERT(s && !*s, s);
+        ASSERT(total == 16318216ull * 1024, total);
+        // The unit after space ends the field. Otherwise, it is another
+        // field. If space separates the fields, then the word after space is
+        // always another field, even if it is a unit.
+        std::string name;
+        int32_t n = 0;
+        s = libtext::read("4 K 7", " ", libtext::size(&total), &name, &n);
+        ASSERT(s && !*s, s);
+        ASSERT(total == 4 && "K" == name && n == 7, total, name, n);
+        s = libtext::read("4096\tKiB 1M", " ", libtext::size(&total), 0,
+                          libtext::size(&free));
+        ASSERT(s && !*s, s);
+        ASSERT(total == 4096 && free == 1 << 20, total, free);
+        s = libtext::read("4096 KiB:1M", ":", libtext::size(&total),
+                          libtext::size(&free));
+        ASSERT(s && !*s, s);
+        ASSERT(total == 4 << 20 && free == 1 << 20, total, free);
+        s = libtext::read("4096 Kernel", " ", libtext::size(&total), &name);
+        ASSERT(s && !*s, s);
+        ASSERT(total == 4096 && "Kernel" == name, total, name);
+        s = libtext::read("4096 K,1", ",", libtext::size(&total), 0);
+        ASSERT(s && !*s, s);
+        ASSERT(total == 4096 << 10, total);
+        const char* const badsizes[] = {
+            "", "K", "-1K", "16E", "18446744073709551616",
+            "18014398509481984K", ",1"
+        };
+        for (const char* in : badsizes) {
+            uint64_t v = 7;
+            ASSERT(!libtext::read(in, ",", libtext::size(&v)), in);
+            ASSERT(v == 7, v, in);
+        }
+        // An unknown unit is not a separator.
+        for (const char* in : {"4X", "4KX", "4 KX", "4Kib", "4.K", "4 K K",
+                               "4m", "4mB", "4g", "4 mi"})
+            ASSERT(!libtext::read(in, ",", libtext::size(&total)), in);
+
+        // Durations.
+        using namespace std::chrono;
+        const struct {
+            const char* input;
+            int64_t ns;
+        } durations[] = {
+            {"0", 0},
+            {"90", 90000000000},
+            {"1.5", 1500000000},
+            {"250ms", 250000000},
+            {"1h30m", 5400000000000},
+            {"1m0.5s", 60500000000},
+            {"2d12h", 216000000000000},
+            {"1w", 604800000000000},
+            {"5min", 300000000000},
+            {"100us", 100000},
+            {"100\xc2\xb5s", 100000},
+            {"7ns", 7},
+            {"-1.5h", -5400000000000},
+            {"+3s", 3000000000},
+            {"0.0000000015s", 1},
+            {"9223372036854775807ns", 9223372036854775807},
+            {"-9223372036854775807ns", -9223372036854775807},
+        };
+        for (const auto& t : durations) {
+            nanoseconds v(7);
+            s = libtext::read(t.input, ",", &v);
+            ASSERT(s && !*s, s, t.input);
+            ASSERT(v.count() == t.ns, v.count(), t.ns, t.input);
+        }
+        milliseconds timeout(7);
+        seconds interval(7);
+        duration<double> elapsed(7);
+        s = libtext::read("timeout=1m30.25s interval=1500ms elapsed=2.5s",
+                          " ", &timeout, &interval, &elapsed);
+        ASSERT(!s, s);
+        s = libtext::read("1m30.25s,1999ms,2.5", ",", &timeout, &interval,
+                          &elapsed);
+        ASSERT(s && !*s, s);
+        ASSERT(timeout.count() == 90250, timeout.count());
+        ASSERT(interval.count() == 1, interval.count());
+        ASSERT(elapsed.count() == 2.5, elapsed.count());
+        const char* const baddurations[] = {
+            "", "s", "1h30", "--1s", "9223372036854775808ns", "106752d",
+            "2562047h47m16.854775808s", ",1"
+        };
+        for (const char* in : baddurations) {
+            milliseconds v(7);
+            ASSERT(!libtext::read(in, ",", &v), in);
+            ASSERT(v.count() == 7, v.count(), in);
+        }
+        for (const char* in : {"1x", "1h 30m", "1.h", "1s-1s", "1e3s"})
+            ASSERT(!libtext::read(in, ",", &timeout), in);
+
+        // Empty fields keep the default value.
+        total = 7;
+        timeout = milliseconds(7);
+        s = libtext::read(",", libtext::empty_fields(","),
+                          libtext::size(&total), &timeout);
+        ASSERT(s && !*s, s);
+        ASSERT(total == 7 && timeout.count() == 7, total, timeout.count());
+        break;
+    }
+    case 35: {
+        // A placeholder or a number.
+        int64_t used = 7, avail = 7;
+        double rtt = 7;
+        s = libtext::read("- 1024 N/A", " ",
+                          libtext::or_sentinel(&used, "-", -1),
+                          libtext::or_sentinel(&avail, "-", -1),
+                          libtext::or_sentinel(&rtt, "N/A", -1.0));
+        ASSERT(s && !*s, s);
+        ASSERT(used == -1 && avail == 1024 && rtt == -1, used, avail, rtt);
+        s = libtext::read("-5,-,0.25", ",",
+                          libtext::or_sentinel(&used, "-", 0),
+                          libtext::or_sentinel(&avail, "-", 0),
+                          libtext::or_sentinel(&rtt, "N/A", -1.0));
+        ASSERT(s && !*s, s);
+        ASSERT(used == -5 && avail == 0 && rtt == 0.25, used, avail, rtt);
+        s = libtext::read(" N/A \t, N/A", ",",
+                          libtext::or_sentinel(&rtt, "N/A", -2.0),
+                          libtext::or_sentinel(&used, "N/A", 3));
+        ASSERT(s && !*s, s);
+        ASSERT(rtt == -2 && used == 3, rtt, used);
+
+        // A field is scanned once. Only a placeholder counts as one.
+        typedef libtext::statistics st;
+        const st before = libtext::stats();
+        s = libtext::read("- 1024", " ", libtext::or_sentinel(&used, "-", -1),
+                          libtext::or_sentinel(&avail, "-", -1));
+        ASSERT(s && !*s, s);
+        const st after = libtext::stats();
+#ifdef LIBTEXT_STATS
+        const uint64_t n = 1;
+#else
+        const uint64_t n = 0;
+#endif
+        ASSERT(after.bytes_scanned - before.bytes_scanned == n * 6,
+               after.bytes_scanned - before.bytes_scanned);
+        ASSERT(after.fields[st::placeholder] - before.fields[st::placeholder]
+               == n, after.fields[st::placeholder]);
+        ASSERT(after.fields[st::int64] - before.fields[st::int64] == n,
+               after.fields[st::int64]);
+
+        // The foreign address of a listening socket in netstat.
+        struct in_addr addr;
+        uint16_t port = 7;
+        s = libtext::read("0.0.0.0:*", ":", &addr,
+                          libtext::or_sentinel(&port, "*", 0));
+        ASSERT(s && !*s, s);
+        ASSERT(addr.s_addr == 0 && port == 0, port);
+
+        // Other types.
+        libtext::decimal<2> price{7};
+        std::chrono::milliseconds timeout(7);
+        s = libtext::read("N/A,N/A", ",",
+                          libtext::or_sentinel(&price, "N/A",
+                                               libtext::decimal<2>{-1}),
+                          libtext::or_sentinel(&timeout, "N/A",
+                                               std::chrono::seconds(1)));
+        ASSERT(s && !*s, s);
+        ASSERT(price.mantissa == -1 && timeout.count() == 1000,
+               price.mantissa, timeout.count());
+
+        // A malformed field is still malformed.
+        used = 7;
+        ASSERT(!libtext::read("N/B", " ",
+                              libtext::or_sentinel(&used, "N/A", -1)));
+        ASSERT(!libtext::read("N/A/B", " ",
+                              libtext::or_sentinel(&used, "N/A", -1)));
+        ASSERT(!libtext::read("--", " ",
+                              libtext::or_sentinel(&used, "-", -1)));
+        ASSERT(!libtext::read("", " ", libtext::or_sentinel(&used, "-", -1)));
+        ASSERT(used == 7, used);
+        ASSERT(!libtext::read("-;1", ",",
+                              libtext::or_sentinel(&used, "-", -1), 0));
+        ASSERT(!libtext::read("-,", ",",
+                              libtext::or_sentinel(&used, "-", -1), 0));
+        ASSERT(!libtext::read("-,,1", ",",
+                              libtext::or_sentinel(&used, "-", -1), 0));
+        s = libtext::read("- 1", " ", libtext::or_sentinel(&used, "-", -1));
+        ASSERT(s && *s == '1', s);
+
+        // Empty fields keep the default value.
+        used = avail = 7;
+        s = libtext::read(",-", libtext::empty_fields(","),
+                          libtext::or_sentinel(&used, "-", -1),
+                          libtext::or_sentinel(&avail, "-", -1));
+        ASSERT(s && !*s, s);
+        ASSERT(used == 7 && avail == -1, used, avail);
+        break;
+    }
     default:
         std::cerr << "case " << test << " not found" << std::endl;
         status = 65;
@@ -0,0 +1,86 @@
+#ifndef _TOKEN_PROBE_H_
+#define _TOKEN_PROBE_H_
+
+/* Static user space tracepoints (USDT) of libtoken.
+
+   When libtoken is built with PROBES=1, TOKEN_PROBE1..3 emit a nop at the
+   probe site and describe the probe in an ELF note of type 3 in section
+   .note.stapsdt, the same way as STAP_PROBE of <sys/sdt.h> does.  bpftrace,
+   perf, systemtap and gdb find the probes in the note and replace the nop
+   with a breakpoint only while a probe is traced, e.g.
+
+   bpftrace -e 'usdt:./libtoken.so:libtoken:next_dequoted_token { ... }'
+
+   Thus, a probe costs a nop when it is not traced.
+   The note has no semaphore and this header does not need <sys/sdt.h>.
+   Without PROBES=1 the macros expand to nothing.  */
+
+#if defined TOKEN_PROBES && defined __GNUC__ && defined __ELF__
+
+#if defined __LP64__ || defined _LP64
+#define TOKEN_PROBE_ADDR ".8byte"
+#define TOKEN_PROBE_ARGSIZE "8"
+#else
+#define TOKEN_PROBE_ADDR ".4byte"
+#define TOKEN_PROBE_ARGSIZE "4"
+#endif
+
+/* An argument is passed as a signed long, which has the size of a pointer.
+   "nor" lets the compiler leave the argument in a register, in memory or as
+   an immediate, whichever is at hand.  */
+#define TOKEN_PROBE_ARG(n) "-" TOKEN_PROBE_ARGSIZE "@%" #n
+
+#define TOKEN_PROBE_ASM(provider, name, args, ...)                          \
+  __asm__ __volatile__ (                                                    \
+    "990: nop\n"                                                            \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                           \
+    ".balign 4\n"                                                           \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                      \
+    "991: .asciz \"stapsdt\"\n"                                             \
+    "992: .balign 4\n"                                                      \
+    "993: " TOKEN_PROBE_ADDR " 990b\n"                                      \
+    TOKEN_PROBE_ADDR " _.stapsdt.base\n"                                    \
+    TOKEN_PROBE_ADDR " 0\n"                                                 \
+    ".asciz \"" #provider "\"\n"                                            \
+    ".asciz \"" #name "\"\n"                                                \
+    ".asciz \"" args "\"\n"                                                 \
+    "994: .balign 4\n"                                                      \
+    ".popsection\n"                                                         \
+    ".ifndef _.stapsdt.base\n"                                              \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n"                                                \
+    ".hidden _.stapsdt.base\n"                                              \
+    "_.stapsdt.base: .space 1\n"                                            \
+    ".size _.stapsdt.base, 1\n"                                             \
+    ".popsection\n"                                                         \
+    ".endif\n"                                                              \
+    :: __VA_ARGS__)
+
+#define TOKEN_PROBE1(provider, name, a)                                     \
+  TOKEN_PROBE_ASM (provider, name, TOKEN_PROBE_ARG (0), "nor" ((long) (a)))
+#define TOKEN_PROBE2(provider, name, a, b)                                  \
+  TOKEN_PROBE_ASM (provider, name,                                          \
+                   TOKEN_PROBE_ARG (0) " " TOKEN_PROBE_ARG (1),             \
+                   "nor" ((long) (a)), "nor" ((long) (b)))
+#define TOKEN_PROBE3(provider, name, a, b, c)                               \
+  TOKEN_PROBE_ASM (provider, name,                                          \
+                   TOKEN_PROBE_ARG (0) " " TOKEN_PROBE_ARG (1) " "          \
+                   TOKEN_PROBE_ARG (2),                                     \
+                   "nor" ((long) (a)), "nor" ((long) (b)),                  \
+                   "nor" ((long) (c)))
+
+#else
+
+#define TOKEN_PROBE1(provider, name, a) ((void) 0)
+#define TOKEN_PROBE2(provider, name, a, b) ((void) 0)
+#define TOKEN_PROBE3(provider, name, a, b, c) ((void) 0)
+
+#endif
+#endif
+
+/* Copyright (c) 2023 Dmitry Goncharov
+ * dgoncharov@users.sf.net.
+ *
+ * Distributed under GPL v2 or the BSD License (see accompanying file COPYING),
+ * your choice.
+ */
@@ -0,0 +1,153 @@
+/* Measure the throughput of next_dequoted_token.
+
+   Each corpus is generated in memory at sizes from 64K up to 'maxlen'.  At
+   each size the corpus is tokenized repeatedly for at least 'min_seconds'.
+   Bytes per second, tokens per second and nanoseconds per byte are reported.
+   The last column is nanoseconds per byte relative to the smallest size.  A
+   tokenizer, which is linear in the length of input, keeps this ratio near 1.
+   A quadratic one doubles the ratio each time the size doubles.  A corpus
+   stops growing once a single pass takes longer than 'max_seconds'.  */
+#include "token.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+/* The input of a benchmark.  The input begins with 'prefix', then 'unit' is
+   repeated and the input ends with 'suffix'.  */
+struct corpus
+{
+  const char *name;
+  const char *prefix;
+  const char *unit;
+  const char *suffix;
+};
+
+static const struct corpus corpora[] = {
+  {"words", "", "hello world -Wall src/token.c ", ""},
+  {"quoted", "", "'single quoted' \"double \\\"quoted\\\" text\" ", ""},
+  {"escapes", "", "a\\ b\\\\c\\'d\\\"e ", ""},
+  {"continuations", "", "cc -c token.c \\\n  -Wall \\\n\\\n\\\n  -O2 \\\n", ""},
+  {"dquoted continuations", "\"", "x \\\n ", "\""},
+  {"single token", "", "abcdefgh", ""},
+  {"single quoted token", "'", "abc def\n", "'"},
+  {"single escaped token", "", "ab\\ cd\\\\", ""},
+  {0, 0, 0, 0}
+};
+
+enum { minlen = 64 * 1024 };
+static const double min_seconds = 0.2;
+static const double max_seconds = 1;
+
+static void generate (const struct corpus *c, char *buf, size_t len);
+static double now (void);
+static double tokenize (char *work, const char *input, size_t len,
+                        size_t *ntokens);
+
+int
+main (int argc, char *argv[])
+{
+  const struct corpus *c;
+  size_t len, maxlen = 4 * 1024 * 1024;
+  char *input, *work;
+
+  if (argc > 2 || (argc == 2 && (maxlen = strtoul (argv[1], 0, 0)) < minlen))
+    {
+      fprintf (stderr, "usage: %s [maxlen >= %d]\n", argv[0], minlen);
+      return 1;
+    }
+
+  input = (char*) malloc (maxlen + 1);
+  work = (char*) malloc (maxlen + 1);
+  if (input == 0 || work == 0)
+    {
+      fprintf (stderr, "cannot allocate %lu bytes\n", (unsigned long) maxlen);
+      return 1;
+    }
+
+  printf ("%-22s %9s %10s %12s %8s %8s\n", "corpus", "bytes", "MB/s",
+          "Mtokens/s", "ns/byte", "scaling");
+  for (c = corpora; c->name; ++c)
+    {
+      double base = 0;
+      for (len = minlen; len <= maxlen; len *= 2)
+        {
+          double elapsed = 0, pass = 0, nsbyte;
+          size_t runs = 0, ntokens = 0;
+
+          generate (c, input, len);
+          while (elapsed < min_seconds)
+            {
+              pass = tokenize (work, input, len, &ntokens);
+              elapsed += pass;
+              ++runs;
+            }
+          nsbyte = elapsed * 1e9 / ((double) runs * len);
+          if (base == 0)
+            base = nsbyte;
+          printf ("%-22s %9lu %10.1f %12.2f %8.2f %8.2f\n", c->name,
+                  (unsigned long) len, runs * len / elapsed / 1e6,
+                  runs * ntokens / elapsed / 1e6, nsbyte, nsbyte / base);
+          fflush (stdout);
+          if (pass > max_seconds)
+            break;
+        }
+    }
+
+  free (work);
+  free (input);
+  return 0;
+}
+
+/* Store to 'buf' the first 'len' characters of corpus 'c' and null terminate
+   'buf'.  */
+static void
+generate (const struct corpus *c, char *buf, size_t len)
+{
+  const size_t plen = strlen (c->prefix), ulen = strlen (c->unit);
+  const size_t slen = strlen (c->suffix);
+  size_t k;
+
+  assert (len > plen + slen);
+  memcpy (buf, c->prefix, plen);
+  for (k = plen; k < len - slen; ++k)
+    buf[k] = c->unit[(k - plen) % ulen];
+  memcpy (buf + len - slen, c->suffix, slen);
+  buf[len] = '\0';
+}
+
+/* Return the current time in seconds.  */
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Tokenize a copy of the first 'len' characters of 'input' in 'work'.
+   Store the number of tokens to '*ntokens'.
+   Return the time spent in next_dequoted_token.  */
+static double
+tokenize (char *work, const char *input, size_t len, size_t *ntokens)
+{
+  char *s = work;
+  size_t tlen, n = 0;
+  int status = 0;
+  double beg;
+
+  memcpy (work, input, len + 1);
+  beg = now ();
+  while (next_dequoted_token (&s, &tlen, &status))
+    ++n;
+  *ntokens = n;
+  return now () - beg;
+}
+
+/* Copyright (c) 2023 Dmitry Goncharov
+ * dgoncharov@users.sf.net.
+ *
+ * Distributed under GPL v2 or the BSD License (see accompanying file COPYING),
+ * your choice.
+ */
@@ -1,20 +1,141 @@
 #include "token.h"
+#include "probe.h"
 #include <string.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <assert.h>
 
+/* The states of the tokenizer between two characters of input.
+   These states let the tokenizer stop at the end of a chunk of input and
+   resume with the next chunk.  */
+enum
+{
+  TS_SEP,           /* Between tokens.  */
+  TS_SEP_ESC,       /* Between tokens, after a backslash, which either escapes
+                       a newline or begins a token.  */
+  TS_WORD,          /* In a token, outside of quotes.  */
+  TS_WORD_ESC,      /* In a token, outside of quotes, after an odd number of
+                       backslashes.  */
+  TS_SQUOTE,        /* Inside single quotes.  */
+  TS_DQUOTE,        /* Inside double quotes.  */
+  TS_DQUOTE_ESC,    /* Inside double quotes, after an odd number of
+                       backslashes.  */
+  TS_NSTATES
+};
+
+/* The character classes.  A character may have no class or one class.
+   TC_NEWLINE is set along with TC_SEP when a newline is a separator.  */
+enum
+{
+  TC_SEP = 1,       /* A token separator.  */
+  TC_NEWLINE = 2,   /* A newline, which serves as a token separator.  */
+  TC_SQUOTE = 4,    /* A single quote.  */
+  TC_DQUOTE = 8,    /* A double quote.  */
+  TC_ESCAPE = 16,   /* An escape character.  */
+  TC_DOLLAR = 32,   /* A $.  */
+  TC_BACKTICK = 64, /* A `.  */
+  TC_GLOB = 128     /* A *, ? or [.  */
+};
+
+/* The default character classes.
+   Space, tab and newline serve as token separators.
+   Various shells, posix and GNU Make do not honor form-feed, carriage return
+   or vertical tab as token delimiters, even though isspace returns true for
+   those characters.  */
+static const struct token_syntax default_syntax =
+{
+  {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, TC_SEP, TC_SEP | TC_NEWLINE, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    TC_SEP, 0, TC_DQUOTE, 0, TC_DOLLAR, 0, 0, TC_SQUOTE,
+    0, 0, TC_GLOB, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, TC_GLOB,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, TC_GLOB, TC_ESCAPE, 0, 0, 0,
+    TC_BACKTICK
+  }
+};
+
+/* A piece of input tokenized by one thread of parallel_dequoted_tokens.  */
+struct chunk
+{
+  size_t beg;                         /* The first character of the chunk.  */
+  size_t end;                         /* The end of the chunk.  */
+  unsigned char exit[TS_NSTATES];     /* The state at the end of the chunk for
+                                         each state at the beginning.  */
+  int entry;                          /* The state at the beginning.  */
+  size_t ntokens;                     /* The number of tokens, which begin in
+                                         this chunk.  */
+  int status;                         /* Set if the closing quote is
+                                         missing.  */
+};
+
+/* The input and output of parallel_dequoted_tokens shared by all threads.  */
+struct tokenizer
+{
+  char *s;
+  size_t slen;
+  char **tokens;
+  size_t *tokenlens;
+  const struct token_syntax *syntax;
+  struct chunk *chunks;
+  size_t nchunks;
+  int nthreads;
+  int phase;
+};
+
+/* The first chunk of a thread of parallel_dequoted_tokens.  Each thread
+   processes every 'nthreads'th chunk.  */
+struct worker
+{
+  struct tokenizer *tk;
+  size_t first;
+};
+
 static const char quotes_and_separators[] = "'\" \t\n";
 static const char *separators = quotes_and_separators + 2;
-static const char *next_token (const char **s, size_t *tokenlen, int *status);
-static char *dequote (char *s, size_t *slen);
-static char *quote_removal_in_double_quotes (char *s, size_t *slen);
-static char *quote_removal_in_single_quotes (char *s, size_t *slen);
-static int whitespace (char c);
-static const char *skip_separators (const char *s);
-static const char *skip_until_separator (const char *s);
-static size_t strecspn (const char *s, const char *reject);
-static size_t memecspn (const char *s, const char *reject, size_t slen);
-static char *collapse_escaped_newlines (char *s, char *beg, const char **endp);
+static const char *next_token (const char **s, size_t *tokenlen, int *status,
+                               int *flags, const struct token_syntax *syntax);
+static char *dequote (char *s, size_t *slen,
+                      const struct token_syntax *syntax);
+static char *quote_removal_in_double_quotes (char *s, size_t *slen,
+                                           const struct token_syntax *syntax);
+static char *quote_removal_in_single_quotes (char *s, size_t *slen,
+                                           const struct token_syntax *syntax);
+static int cls (const struct token_syntax *syntax, char c);
+static int escaped_newline (const char *s, const struct token_syntax *syntax);
+static int flag_of (int c);
+static const char *skip_separators (const char *s,
+                                    const struct token_syntax *syntax);
+static const char *skip_until_separator (const char *s,
+                                         const struct token_syntax *syntax,
+                                         int stop, int *flags);
+static size_t strecspn (const char *s, const unsigned char *cls, int reject,
+                        int escape);
+static size_t memecspn (const char *s, const unsigned char *cls, int reject,
+                        int escape, size_t slen);
+static char *collapse_escaped_newlines (char *s, char *beg, const char **endp,
+                                        const struct token_syntax *syntax);
+static int next_state (int state, int c);
+static int in_token (int state);
+static int dequoted_tokens_impl (char *s, size_t slen, char **tokens,
+                                 size_t *tokenlens, size_t *ntokens,
+                                 int *status, int nthreads, size_t chunklen,
+                                 const struct token_syntax *syntax);
+static void run_phase (struct tokenizer *tk, int phase);
+static void *tokenize_chunks (void *arg);
+static void chunk_transitions (const char *s,
+                               const struct token_syntax *syntax,
+                               struct chunk *c);
+static void chunk_tokens (struct tokenizer *tk, struct chunk *c);
+static void chunk_dequote (struct tokenizer *tk, struct chunk *c);
+static int needs_quoting (const char *s, size_t slen);
+static size_t quoted_len (int mode, const char *s, size_t slen, int last);
+static char *put_quoted (char *p, int mode, const char *s, size_t slen,
+                         int last);
 
 
 /* 's' is mutable, because next_dequoted_token dequotes the token in place.
@@ -43,18 +164,647 @@ static char *collapse_escaped_newlines (char *s, char *beg, const char **endp);
   argv[argc] = 0;  */
 char *
 next_dequoted_token (char **s, size_t *tokenlen, int *status)
+{
+  return next_dequoted_token_syntax (s, tokenlen, status, &default_syntax);
+}
+
+void
+token_syntax_init (struct token_syntax *syntax, const char *separators_,
+                   char squote, char dquote, char escape)
+{
+  const char *p;
+
+  memset (syntax->cls, 0, sizeof syntax->cls);
+  syntax->cls['$'] = TC_DOLLAR;
+  syntax->cls['`'] = TC_BACKTICK;
+  syntax->cls['*'] = syntax->cls['?'] = syntax->cls['['] = TC_GLOB;
+  if (separators_ == 0)
+    separators_ = separators;
+  for (p = separators_; *p; ++p)
+    syntax->cls[(unsigned char) *p] = TC_SEP;
+  if (syntax->cls['\n'])
+    syntax->cls['\n'] |= TC_NEWLINE;
+  if (squote)
+    syntax->cls[(unsigned char) squote] = TC_SQUOTE;
+  if (dquote)
+    syntax->cls[(unsigned char) dquote] = TC_DQUOTE;
+  if (escape)
+    syntax->cls[(unsigned char) escape] = TC_ESCAPE;
+}
+
+char *
+next_dequoted_token_syntax (char **s, size_t *tokenlen, int *status,
+                            const struct token_syntax *syntax)
+{
+  return next_dequoted_token_flags (s, tokenlen, status, 0, syntax);
+}
+
+char *
+next_dequoted_token_flags (char **s, size_t *tokenlen, int *status,
+                           int *flags, const struct token_syntax *syntax)
 {
   int st = 0;
-  char *token = (char*) next_token ((const char **)s, tokenlen, &st);
+  char *token;
+
+  TOKEN_PROBE1 (libtoken, next_dequoted_token, *s);
+  if (syntax == 0)
+    syntax = &default_syntax;
+  token = (char*) next_token ((const char **)s, tokenlen, &st, flags, syntax);
   *status |= st;
   if (token && st == 0)
-    dequote (token, tokenlen);
+    dequote (token, tokenlen, syntax);
+  else if (st)
+    /* The only failure is a missing closing quote.  */
+    TOKEN_PROBE3 (libtoken, next_dequoted_token_failure, token, *tokenlen,
+                  st);
   return token;
 }
 
+void
+token_stream_init (struct token_stream *ts)
+{
+  memset (ts, 0, sizeof *ts);
+  ts->state = TS_SEP;
+}
+
+void
+token_stream_free (struct token_stream *ts)
+{
+  free (ts->buf);
+  token_stream_init (ts);
+}
+
+int
+token_stream_feed (struct token_stream *ts, const char *chunk, size_t len)
+{
+  if (len == 0)
+    {
+      ts->eof = 1;
+      return 0;
+    }
+
+  /* Discard the tokens which were already returned and the separators which
+     follow them.  */
+  if (ts->pos > 0)
+    {
+      memmove (ts->buf, ts->buf + ts->pos, ts->len - ts->pos);
+      ts->len -= ts->pos;
+      ts->scanned -= ts->pos;
+      ts->pos = 0;
+    }
+
+  if (ts->len + len + 1 > ts->size)
+    {
+      size_t size = ts->size ? ts->size : 64;
+      char *buf;
+      while (size < ts->len + len + 1)
+        size *= 2;
+      buf = (char*) realloc (ts->buf, size);
+      if (buf == 0)
+        return -1;
+      ts->buf = buf;
+      ts->size = size;
+    }
+
+  memcpy (ts->buf + ts->len, chunk, len);
+  ts->len += len;
+  ts->buf[ts->len] = '\0';
+  return 0;
+}
+
+/* Scan the input from where the previous call stopped.  This function runs
+   the same state machine as next_token, one character at a time, to have the
+   state survive the end of a chunk.  */
+char *
+token_stream_next (struct token_stream *ts, size_t *tokenlen, int *status)
+{
+  char *token;
+  size_t k, end;
+  int state = ts->state;
+  const struct token_syntax *syntax = ts->syntax ? ts->syntax
+                                                 : &default_syntax;
+
+  *tokenlen = 0;
+  for (k = ts->scanned; k < ts->len; ++k)
+    {
+      const int prev = state;
+      state = next_state (state, cls (syntax, ts->buf[k]));
+
+      if (prev == TS_SEP)
+        {
+          /* Keep 'pos' at the first character which is not a separator.  */
+          ts->pos = state == TS_SEP ? k + 1 : k;
+          continue;
+        }
+      if (prev == TS_SEP_ESC)
+        {
+          if (state == TS_SEP)
+            /* This backslash escaped a newline.  */
+            ts->pos = k + 1;
+          /* Otherwise, the token begins with the backslash at 'pos'.  */
+          continue;
+        }
+      if (state != TS_SEP)
+        continue;
+
+      /* Found the end of the token.
+         A backslash which escapes a newline serves as a separator.  */
+      end = prev == TS_WORD_ESC ? k - 1 : k;
+      token = ts->buf + ts->pos;
+      *tokenlen = end - ts->pos;
+      ts->pos = ts->scanned = k + 1;
+      ts->state = state;
+      return dequote (token, tokenlen, syntax);
+    }
+
+  ts->scanned = ts->len;
+  ts->state = state;
+  if (!ts->eof || state == TS_SEP)
+    {
+      /* Either the token is not complete yet or there is no token.  */
+      if (state == TS_SEP)
+        ts->pos = ts->len;
+      return 0;
+    }
+
+  /* The end of input is the end of the last token.  */
+  token = ts->buf + ts->pos;
+  *tokenlen = ts->len - ts->pos;
+  ts->pos = ts->len;
+  ts->state = TS_SEP;
+  if (state == TS_SQUOTE || state == TS_DQUOTE || state == TS_DQUOTE_ESC)
+    {
+      /* Closing quote is missing.  */
+      *status |= 1;
+      return token;
+    }
+  return dequote (token, tokenlen, syntax);
+}
+
+/* The smallest chunk of input worth a thread of its own.  */
+enum { min_chunklen = 64 * 1024 };
+
+int
+parallel_dequoted_tokens (char *s, char **tokens, size_t *tokenlens,
+                          size_t *ntokens, int *status, int nthreads,
+                          const struct token_syntax *syntax)
+{
+  const size_t slen = strlen (s);
+  size_t chunklen;
+
+  if (nthreads < 1)
+    nthreads = 1;
+  chunklen = slen / nthreads + 1;
+  if (chunklen < min_chunklen)
+    chunklen = min_chunklen;
+  return dequoted_tokens_impl (s, slen, tokens, tokenlens, ntokens, status,
+                               nthreads, chunklen,
+                               syntax ? syntax : &default_syntax);
+}
+
+/* Split '[s, s + slen)' in chunks of 'chunklen' characters.  Tokenize the
+   chunks using 'nthreads' threads.
+
+   Each of the three phases is run by all threads.  A phase does not begin
+   until the previous phase is complete.
+   1. Compute the transitions of each chunk.  Then chain the transitions to
+   find the state at the beginning of each chunk.
+   2. Find the tokens of each chunk.  A token belongs to the chunk where the
+   token begins.  A chunk skips the end of the token, which began in a previous
+   chunk, and scans past the end of the chunk to find the end of its own last
+   token.  All threads only read the input during this phase.
+   3. Dequote the tokens of each chunk.  The tokens are disjoint and each token
+   is dequoted by one thread.
+
+   Each token is separated from the next one by at least one separator.
+   Therefore, a chunk of an even length has no more than chunklen / 2 tokens
+   and the tokens of a chunk beginning at 'beg' can be stored in 'tokens',
+   starting from 'beg / 2', without overlap with the tokens of other chunks.
+   The tokens are then moved to the beginning of 'tokens'.  */
+static int
+dequoted_tokens_impl (char *s, size_t slen, char **tokens, size_t *tokenlens,
+                      size_t *ntokens, int *status, int nthreads,
+                      size_t chunklen, const struct token_syntax *syntax)
+{
+  struct tokenizer tk;
+  size_t k, n;
+  int state;
+
+  chunklen += chunklen % 2;
+  tk.s = s;
+  tk.slen = slen;
+  tk.tokens = tokens;
+  tk.tokenlens = tokenlens;
+  tk.syntax = syntax;
+  tk.nchunks = slen / chunklen + 1;
+  tk.nthreads = nthreads;
+  tk.chunks = (struct chunk*) malloc (tk.nchunks * sizeof *tk.chunks);
+  if (tk.chunks == 0)
+    return -1;
+  for (k = 0; k < tk.nchunks; ++k)
+    {
+      tk.chunks[k].beg = k * chunklen;
+      tk.chunks[k].end = k + 1 < tk.nchunks ? (k + 1) * chunklen : slen;
+      tk.chunks[k].ntokens = 0;
+      tk.chunks[k].status = 0;
+    }
+
+  run_phase (&tk, 1);
+  for (k = 0, state = TS_SEP; k < tk.nchunks; ++k)
+    {
+      tk.chunks[k].entry = state;
+      state = tk.chunks[k].exit[state];
+    }
+  run_phase (&tk, 2);
+  run_phase (&tk, 3);
+
+  for (k = 0, n = 0; k < tk.nchunks; ++k)
+    {
+      const struct chunk *c = tk.chunks + k;
+      memmove (tokens + n, tokens + c->beg / 2, c->ntokens * sizeof *tokens);
+      memmove (tokenlens + n, tokenlens + c->beg / 2,
+               c->ntokens * sizeof *tokenlens);
+      n += c->ntokens;
+      *status |= c->status;
+    }
+  *ntokens = n;
+  free (tk.chunks);
+  return 0;
+}
+
+/* Run 'phase' on all chunks of 'tk'.
+   If a thread cannot be created, the calling thread processes its chunks.  */
+static void
+run_phase (struct tokenizer *tk, int phase)
+{
+  pthread_t *threads;
+  struct worker *workers;
+  int k, nthreads = tk->nthreads;
+  int *created;
+
+  tk->phase = phase;
+  if ((size_t) nthreads > tk->nchunks)
+    nthreads = (int) tk->nchunks;
+  threads = (pthread_t*) malloc (nthreads * sizeof *threads);
+  workers = (struct worker*) malloc (nthreads * sizeof *workers);
+  created = (int*) calloc (nthreads, sizeof *created);
+  if (threads == 0 || workers == 0 || created == 0)
+    nthreads = 1;
+  tk->nthreads = nthreads;
+
+  for (k = 1; k < nthreads; ++k)
+    {
+      workers[k].tk = tk;
+      workers[k].first = k;
+      created[k] = pthread_create (threads + k, 0, tokenize_chunks,
+                                   workers + k) == 0;
+    }
+  for (k = 0; k < nthreads; ++k)
+    if (k == 0 || !created[k])
+      {
+        struct worker w;
+        w.tk = tk;
+        w.first = k;
+        /* The chunks of thread 0 are processed by the calling thread.  */
+        tokenize_chunks (&w);
+      }
+  for (k = 1; k < nthreads; ++k)
+    if (created[k])
+      pthread_join (threads[k], 0);
+
+  free (created);
+  free (workers);
+  free (threads);
+}
+
+/* Process every 'nthreads'th chunk, starting from chunk 'first'.  */
+static void *
+tokenize_chunks (void *arg)
+{
+  const struct worker *w = (const struct worker*) arg;
+  struct tokenizer *tk = w->tk;
+  size_t k;
+
+  for (k = w->first; k < tk->nchunks; k += tk->nthreads)
+    switch (tk->phase)
+      {
+      case 1:
+        chunk_transitions (tk->s, tk->syntax, tk->chunks + k);
+        break;
+      case 2:
+        chunk_tokens (tk, tk->chunks + k);
+        break;
+      case 3:
+        chunk_dequote (tk, tk->chunks + k);
+        break;
+      }
+  return 0;
+}
+
+/* Compute the state at the end of chunk 'c' for each state at the beginning.
+   Once two states meet they stay together.  Therefore, only the distinct
+   states are advanced, which are usually just a few after the first few
+   characters of the chunk.  */
+static void
+chunk_transitions (const char *s, const struct token_syntax *syntax,
+                   struct chunk *c)
+{
+  unsigned char state[TS_NSTATES], map[TS_NSTATES];
+  int k, j, e, n = TS_NSTATES;
+  size_t i;
+
+  /* 'state' holds the distinct states.  'map' maps each state at the
+     beginning to its distinct state.  */
+  for (k = 0; k < n; ++k)
+    state[k] = map[k] = (unsigned char) k;
+
+  for (i = c->beg; i < c->end; ++i)
+    {
+      const int ci = cls (syntax, s[i]);
+      for (k = 0; k < n; ++k)
+        state[k] = (unsigned char) next_state (state[k], ci);
+      for (k = n - 1; k > 0; --k)
+        for (j = 0; j < k; ++j)
+          if (state[j] == state[k])
+            {
+              /* Merge 'k' to 'j' and move the last state to 'k'.  */
+              --n;
+              for (e = 0; e < TS_NSTATES; ++e)
+                if (map[e] == k)
+                  map[e] = (unsigned char) j;
+                else if (map[e] == n)
+                  map[e] = (unsigned char) k;
+              state[k] = state[n];
+              break;
+            }
+    }
+
+  for (e = 0; e < TS_NSTATES; ++e)
+    c->exit[e] = state[map[e]];
+}
+
+/* Find the tokens which begin in chunk 'c'.
+   Store the beginning and the length of each token in 'tk->tokens' and
+   'tk->tokenlens', starting from 'c->beg / 2'.  */
+static void
+chunk_tokens (struct tokenizer *tk, struct chunk *c)
+{
+  const char *s = tk->s;
+  char **tokens = tk->tokens + c->beg / 2;
+  size_t *tokenlens = tk->tokenlens + c->beg / 2;
+  size_t i, beg = 0, n = 0;
+  int own = 0, state = c->entry;
+
+  for (i = c->beg; i < tk->slen; ++i)
+    {
+      int prev;
+      if (i >= c->end && !own)
+        break;
+      prev = state;
+      state = next_state (state, cls (tk->syntax, s[i]));
+      if (!in_token (prev) && in_token (state))
+        {
+          /* A token begins.
+             A backslash which begins a token was read in TS_SEP_ESC.  */
+          beg = prev == TS_SEP_ESC ? i - 1 : i;
+          own = 1;
+        }
+      else if (in_token (prev) && state == TS_SEP)
+        {
+          /* A token ends.
+             A backslash which escapes a newline serves as a separator.  */
+          if (own)
+            {
+              tokens[n] = tk->s + beg;
+              tokenlens[n++] = (prev == TS_WORD_ESC ? i - 1 : i) - beg;
+            }
+          own = 0;
+        }
+    }
+
+  if (i == tk->slen && i > c->beg)
+    {
+      /* The end of input is the end of the last token.  */
+      if (own)
+        {
+          tokens[n] = tk->s + beg;
+          tokenlens[n++] = i - beg;
+          if (state == TS_SQUOTE || state == TS_DQUOTE
+              || state == TS_DQUOTE_ESC)
+            /* Closing quote is missing.  */
+            c->status = 1;
+        }
+      else if (state == TS_SEP_ESC)
+        {
+          /* A lone backslash at the end of input is a token.  */
+          tokens[n] = tk->s + i - 1;
+          tokenlens[n++] = 1;
+        }
+    }
+  c->ntokens = n;
+}
+
+/* Dequote the tokens of chunk 'c'.  */
+static void
+chunk_dequote (struct tokenizer *tk, struct chunk *c)
+{
+  char **tokens = tk->tokens + c->beg / 2;
+  size_t *tokenlens = tk->tokenlens + c->beg / 2;
+  size_t k;
+
+  for (k = 0; k < c->ntokens; ++k)
+    /* A token with a missing closing quote is the last one.  */
+    if (c->status == 0 || k + 1 < c->ntokens)
+      dequote (tokens[k], tokenlens + k, tk->syntax);
+}
+
+/* The modes of quote_token.  */
+enum
+{
+  QM_PLAIN,         /* Outside of quotes.  */
+  QM_SQUOTE,        /* Inside single quotes.  */
+  QM_DQUOTE,        /* Inside double quotes.  */
+  QM_NMODES
+};
+
+/* The length of an encoding which does not exist.  Small enough for a sum of
+   a few of these not to overflow.  */
+static const size_t quote_inf = (size_t) -1 / 8;
+
+/* The quote which opens and closes each mode.  */
+static const char mode_quote[QM_NMODES] = {'\0', '\'', '"'};
+
+/* The shortest quoting is found by dynamic programming from the end of 'src'
+   to the beginning.  For each character and each mode the choice between
+   continuing the current quoted segment and closing it is stored in 'dst',
+   past the end of the longest possible result.  Then the result is written
+   from the beginning of 'src' to the end.
+   Quoting every character in double quotes takes no more than
+   2 * srclen + 2 characters.  Therefore, the result of the first i characters
+   is no longer than srclen + 2 + i characters and never overwrites the choice
+   of character i before the choice is read.  */
+size_t
+quote_token (char *dst, const char *src, size_t srclen)
+{
+  unsigned char *choice = (unsigned char*) dst + srclen + 2;
+  size_t f[QM_NMODES], nf[QM_NMODES], g, i;
+  char *p = dst;
+  int m;
+
+  if (srclen == 0)
+    {
+      strcpy (dst, "''");
+      return 2;
+    }
+  if (!needs_quoting (src, srclen))
+    {
+      memcpy (dst, src, srclen);
+      dst[srclen] = '\0';
+      return srclen;
+    }
+
+  /* f[m] is the length of the shortest encoding of '[src + i, src + srclen)'
+     in a segment of mode 'm', which is open at 'src + i'.  g is the length of
+     the shortest encoding of '[src + i, src + srclen)' including the opening
+     quote.  */
+  for (m = 0; m < QM_NMODES; ++m)
+    f[m] = mode_quote[m] != '\0';
+  g = 0;
+  for (i = srclen; i-- > 0; )
+    {
+      unsigned char ch = 0;
+      size_t ng = quote_inf;
+      for (m = 0; m < QM_NMODES; ++m)
+        {
+          const size_t open = mode_quote[m] != '\0';
+          const size_t cont = quoted_len (m, src + i, srclen - i, 0) + f[m];
+          const size_t close = quoted_len (m, src + i, srclen - i, 1) + open
+                               + g;
+          if (close < cont)
+            {
+              nf[m] = close;
+              ch |= (unsigned char) (1 << m);
+            }
+          else
+            nf[m] = cont;
+          if (nf[m] > quote_inf)
+            nf[m] = quote_inf;
+          if (open + nf[m] < ng)
+            {
+              ng = open + nf[m];
+              ch = (unsigned char) ((ch & 7) | m << 3);
+            }
+        }
+      memcpy (f, nf, sizeof f);
+      g = ng;
+      choice[i] = ch;
+    }
+
+  m = choice[0] >> 3;
+  if (mode_quote[m])
+    *p++ = mode_quote[m];
+  for (i = 0; i < srclen; ++i)
+    {
+      const unsigned char ch = choice[i];
+      const int last = i + 1 == srclen || (ch >> m & 1);
+      p = put_quoted (p, m, src + i, srclen - i, last);
+      if (last)
+        {
+          if (mode_quote[m])
+            *p++ = mode_quote[m];
+          if (i + 1 < srclen)
+            {
+              m = choice[i + 1] >> 3;
+              if (mode_quote[m])
+                *p++ = mode_quote[m];
+            }
+        }
+    }
+  *p = '\0';
+  return p - dst;
+}
+
+/* Return 1 if the first 'slen' characters of 's' contain a separator, quote
+   or backslash.
+   Eight characters are tested at once.  A byte of 'x' is zero, if the related
+   character of 's' equals the character being looked for.  The expression
+   (x - ones) & ~x & highs is not zero, if any byte of 'x' is zero.  */
+static int
+needs_quoting (const char *s, size_t slen)
+{
+  const uint64_t ones = 0x0101010101010101ull;
+  const uint64_t highs = 0x8080808080808080ull;
+  uint64_t w, x, r;
+  size_t k;
+
+  for (; slen >= sizeof w; s += sizeof w, slen -= sizeof w)
+    {
+      memcpy (&w, s, sizeof w);
+      x = w ^ (ones * ' ');
+      r = (x - ones) & ~x;
+      x = w ^ (ones * '\t');
+      r |= (x - ones) & ~x;
+      x = w ^ (ones * '\n');
+      r |= (x - ones) & ~x;
+      x = w ^ (ones * '\'');
+      r |= (x - ones) & ~x;
+      x = w ^ (ones * '"');
+      r |= (x - ones) & ~x;
+      x = w ^ (ones * '\\');
+      r |= (x - ones) & ~x;
+      if (r & highs)
+        return 1;
+    }
+  for (k = 0; k < slen; ++k)
+    if (memchr (quotes_and_separators, s[k], sizeof quotes_and_separators - 1)
+        || s[k] == '\\')
+      return 1;
+  return 0;
+}
+
+/* Return the number of characters, which encode the first character of 's'
+   in mode 'mode'.  'slen' is the number of characters left in 's'.  'last'
+   is set if the quoted segment ends after this character.
+   Return quote_inf if the character cannot be encoded in this mode.  */
+static size_t
+quoted_len (int mode, const char *s, size_t slen, int last)
+{
+  switch (mode)
+    {
+    case QM_PLAIN:
+      /* An escaped newline serves as a separator.  */
+      if (*s == '\n')
+        return quote_inf;
+      return memchr ("'\"\\ \t", *s, 5) ? 2 : 1;
+    case QM_SQUOTE:
+      return *s == '\'' ? quote_inf : 1;
+    }
+  if (*s == '"')
+    return 2;
+  /* A backslash which precedes a backslash, double quote, newline or the
+     closing quote has to be escaped.  */
+  if (*s == '\\' && (last || slen < 2 || memchr ("\\\"\n", s[1], 3)))
+    return 2;
+  return 1;
+}
+
+/* Store the encoding of the first character of 's' in mode 'mode' to 'p'.
+   'slen' and 'last' are those of quoted_len.
+   Return the end of the stored encoding.  */
+static char *
+put_quoted (char *p, int mode, const char *s, size_t slen, int last)
+{
+  if (quoted_len (mode, s, slen, last) == 2)
+    *p++ = '\\';
+  *p++ = *s;
+  return p;
+}
+
 /* A not escaped and not quoted space, tab or newline character serves as a
    token separator.
    A not escaped backslash serves as an escape character.
+   These are the default character classes.  Other separators, quotes and
+   escape character can be specified with a token_syntax.
 
    In the absence of quotes, a token is delimited by token separators.
    Beginning of a quoted token is delimited by a pair of a token separator
@@ -73,19 +823,27 @@ next_dequoted_token (char **s, size_t *tokenlen, int *status)
    If an opening quote is present and the closing quote is missing, set
    '*status' to 1.  Otherwise, keep '*status' intact.
    If no token is found, return 0.
+   If 'flags' is not null, set '*flags' to the TOKEN_* bits of the token.
 
-   'status' is a bitmask.
-   The current implementation only sets bit 0. However, it is possible to
-   modify next_token to detect $ or ` and set other bits in 'status'.  */
+   The scan stops at $, ` and glob characters only when 'flags' is not null.
+   Thus, next_dequoted_token does not pay for the flags.  */
 static const char *
-next_token (const char **input, size_t *tokenlen, int *status)
+next_token (const char **input, size_t *tokenlen, int *status, int *flags,
+            const struct token_syntax *syntax)
 {
   const char *token, *s;
+  int fl = 0, stop = TC_SEP | TC_SQUOTE | TC_DQUOTE, dstop = TC_DQUOTE;
 
   assert (*input);
 
+  if (flags)
+    {
+      *flags = 0;
+      stop |= TC_DOLLAR | TC_BACKTICK | TC_GLOB;
+      dstop |= TC_DOLLAR | TC_BACKTICK;
+    }
   *tokenlen = 0;
-  *input = skip_separators (*input);
+  *input = skip_separators (*input, syntax);
   if (**input == '\0')
     /* Only separators in this input.  */
     return 0;
@@ -99,59 +857,77 @@ next_token (const char **input, size_t *tokenlen, int *status)
 
   for (;;)
     {
+      int c;
+
       /* Skip until a separator or quote.  */
-      s = skip_until_separator (s);
+      s = skip_until_separator (s, syntax, stop, &fl);
       if (*s == '\0')
         /* Found the end of the token.  */
         break;
 
-      if (*s == '\\' && s[1] == '\n')
+      c = cls (syntax, *s);
+      if (escaped_newline (s, syntax))
         break;
 
-      if (*s == '\'')
+      if (c & (TC_DOLLAR | TC_BACKTICK | TC_GLOB))
+        {
+          fl |= flag_of (c);
+          ++s;
+          continue;
+        }
+
+      if (c & TC_SQUOTE)
         {
+          fl |= TOKEN_QUOTED;
           /* Advance past the opening quote.  */
           ++s;
           /* Skip until the next single quote, which is the closing quote.  */
-          s += strcspn (s, "'");
+          while (*s && !(cls (syntax, *s) & TC_SQUOTE))
+            ++s;
           if (*s == '\0')
             {
               /* Closing quote is missing.  */
               *status |= 1;
               break;
             }
-          assert (*s == '\'');
           /* Advance past the closing quote.  */
           ++s;
-          if (whitespace (*s))
+          if (cls (syntax, *s) & TC_SEP)
             /* Found the end of the token.  */
             break;
           continue;
         }
 
-      if (*s == '"')
+      if (c & TC_DQUOTE)
         {
+          fl |= TOKEN_QUOTED;
           /* Advance past the opening quote.  */
           ++s;
           /* Skip until a not escaped double quote, which is the closing quote.
-           */
-          s += strecspn (s, "\"");
+             A $ or ` inside double quotes is expanded by a shell.  */
+          for (;;)
+            {
+              s += strecspn (s, syntax->cls, dstop, TC_ESCAPE);
+              if (!(cls (syntax, *s) & (TC_DOLLAR | TC_BACKTICK)))
+                break;
+              fl |= flag_of (cls (syntax, *s));
+              ++s;
+            }
           if (*s == '\0')
             {
               /* Closing quote is missing.  */
               *status |= 1;
               break;
             }
-          assert (*s == '"');
           /* Advance past the closing quote.  */
           ++s;
-          if (whitespace (*s))
+          if (cls (syntax, *s) & TC_SEP)
             /* Found the end of the token.  */
             break;
           continue;
         }
 
-      assert (strchr (separators, *s));
+      assert (c & TC_SEP);
       /* Found the end of the token.  */
       break;
     }
@@ -159,9 +935,11 @@ next_token (const char **input, size_t *tokenlen, int *status)
   /* 'token' points at the begininnig of the token. 's' points immediately
      after the end of the token.  */
   *tokenlen = s - token;
+  if (flags)
+    *flags = fl;
 
   /* Move 's' to the beginning of the next token.  */
-  s = skip_separators (s);
+  s = skip_separators (s, syntax);
   *input = s;
 
   return token;
@@ -172,28 +950,27 @@ next_token (const char **input, size_t *tokenlen, int *status)
    Null terminate the dequoted portion.
    Return 's'.  */
 static char *
-dequote (char *s, size_t *slen)
+dequote (char *s, size_t *slen, const struct token_syntax *syntax)
 {
   char *beg = s;
   const char *end = s + *slen;
-  size_t len = *slen;
+  size_t len;
 
-  s += memecspn (s, "\\'\"", *slen);
   for (s = beg; s < end; )
     {
       len = end - s;
-      switch (*s)
+      switch (cls (syntax, *s))
         {
-        case '\'':
-          s = quote_removal_in_single_quotes (s, &len);
+        case TC_SQUOTE:
+          s = quote_removal_in_single_quotes (s, &len, syntax);
           end = s + len;
           break;
-        case '"':
-          s = quote_removal_in_double_quotes (s, &len);
+        case TC_DQUOTE:
+          s = quote_removal_in_double_quotes (s, &len, syntax);
           end = s + len;
           break;
-        case '\\':
-          if (s[1] == '\n')
+        case TC_ESCAPE:
+          if (cls (syntax, s[1]) & TC_NEWLINE)
             {
               /* This backslash escapes the newline in 's[1]'.
                  Remove the backslash and the newline.  */
@@ -201,7 +978,8 @@ dequote (char *s, size_t *slen)
               end -= 2;
               break;
             }
-          if (strchr ("'\"\\ \t", s[1]))
+          if (cls (syntax, s[1])
+              & (TC_SEP | TC_SQUOTE | TC_DQUOTE | TC_ESCAPE))
             {
               /* This backslash escapes 's[1]'.
                  Remove the backslash.  */
@@ -239,7 +1017,8 @@ dequote (char *s, size_t *slen)
   token and the end of the substring, remaining after quote removal.
   Return the end of the token.  */
 static char *
-quote_removal_in_single_quotes (char *s, size_t *slen)
+quote_removal_in_single_quotes (char *s, size_t *slen,
+                                const struct token_syntax *syntax)
 {
   const char *end = s + *slen;
   char *close;
@@ -247,11 +1026,12 @@ quote_removal_in_single_quotes (char *s, size_t *slen)
   /* These assertions are corrects, because next_dequoted_token calls dequote
      only when the token is well formed.  */
   assert (*slen > 1);
-  assert (*s == '\'');
+  assert (cls (syntax, *s) & TC_SQUOTE);
 
-  close = (char*)  memchr (s + 1, '\'', *slen - 1);
-  assert (close);
-  assert (close > s);
+  for (close = s + 1; close < end && !(cls (syntax, *close) & TC_SQUOTE);
+       ++close)
+    ;
+  assert (close < end);
 
   /* Remove closing single quote.  */
   memmove (close, close + 1, end - close);
@@ -279,16 +1059,16 @@ quote_removal_in_single_quotes (char *s, size_t *slen)
    Because '[s, s + slen)' is one token, there is no need to care about single
    quotes.  */
 static char *
-quote_removal_in_double_quotes (char *s, size_t *slen)
+quote_removal_in_double_quotes (char *s, size_t *slen,
+                                const struct token_syntax *syntax)
 {
-  const char qe[] = {'\\', '"', '\0'};
   char *beg = s;
   const char *end = s + *slen;
 
   /* These assertions are corrects, because next_dequoted_token calls dequote
      only when the token is well formed.  */
   assert (*slen > 1);
-  assert (*s == '"');
+  assert (cls (syntax, *s) & TC_DQUOTE);
 
   /* Remove the opening quote.  */
   memmove (s, s + 1, end - s);
@@ -296,11 +1076,12 @@ quote_removal_in_double_quotes (char *s, size_t *slen)
 
   for (;;)
     {
-      s += memecspn (s, qe, end - s);
+      s += memecspn (s, syntax->cls, TC_ESCAPE | TC_DQUOTE, TC_ESCAPE,
+                     end - s);
       if (s >= end)
         break;
 
-      if (*s == '"')
+      if (cls (syntax, *s) & TC_DQUOTE)
         {
           /* Remove the closing quote.  */
           memmove (s, s + 1, end - s);
@@ -310,13 +1091,13 @@ quote_removal_in_double_quotes (char *s, size_t *slen)
           break;
         }
 
-      assert (*s == '\\');
+      assert (cls (syntax, *s) & TC_ESCAPE);
 
       if (s + 1 >= end)
         /* There is nothing to escape.  */
         break;
 
-      if (s[1] == '\\' || s[1] == '"')
+      if (cls (syntax, s[1]) & (TC_ESCAPE | TC_DQUOTE))
         {
           /* A backslash is escaping either a backslash or a quote.  */
 
@@ -330,9 +1111,9 @@ quote_removal_in_double_quotes (char *s, size_t *slen)
           continue;
         }
 
-      if (s[1] == '\n')
+      if (cls (syntax, s[1]) & TC_NEWLINE)
         {
-          s = collapse_escaped_newlines (s, beg, &end);
+          s = collapse_escaped_newlines (s, beg, &end, syntax);
           continue;
         }
 
@@ -345,57 +1126,83 @@ quote_removal_in_double_quotes (char *s, size_t *slen)
   return s;
 }
 
-/* Return 1 if 'c' is a newline, space or tab.
-   Various shells, posix and GNU Make do not honor form-feed, carriage return
-   or vertical tab as token delimiters, even though isspace returns true for
-   those characters.  */
+/* Return the class of 'c' in 'syntax'.  */
 static int
-whitespace (char c)
+cls (const struct token_syntax *syntax, char c)
 {
-    return c == '\n' || c == ' ' || c == '\t';
+  return syntax->cls[(unsigned char) c];
+}
+
+/* Return 1 if 's' begins with an escape character followed by a newline, which
+   serves as a separator.  */
+static int
+escaped_newline (const char *s, const struct token_syntax *syntax)
+{
+  return (cls (syntax, s[0]) & TC_ESCAPE) && (cls (syntax, s[1]) & TC_NEWLINE);
+}
+
+/* Return the TOKEN_* bit of a character of class 'c'.  */
+static int
+flag_of (int c)
+{
+  if (c & TC_DOLLAR)
+    return TOKEN_DOLLAR;
+  if (c & TC_BACKTICK)
+    return TOKEN_BACKTICK;
+  if (c & TC_GLOB)
+    return TOKEN_GLOB;
+  return 0;
 }
 
 /* Skip separators and escaped newlines.  */
 static const char *
-skip_separators (const char *s)
+skip_separators (const char *s, const struct token_syntax *syntax)
 {
   const char *beg;
   for (beg = 0; beg != s; )
     {
       beg = s;
       /* Skip separators.  */
-      s += strspn (s, separators);
+      while (cls (syntax, *s) & TC_SEP)
+        ++s;
 
       /* Skip an escaped newline.  */
-      if (*s == '\\' && s[1] == '\n')
+      if (escaped_newline (s, syntax))
         s += 2;
     }
   return s;
 }
 
-/* Skip until a separator or a newline or a not escaped newline.  */
+/* Skip until a not escaped character of a class in 'stop' or a newline or a
+   not escaped newline.
+   Set TOKEN_QUOTED in '*flags' if an escape character, which does not escape
+   a newline, is skipped.  */
 static const char *
-skip_until_separator (const char *s)
+skip_until_separator (const char *s, const struct token_syntax *syntax,
+                      int stop, int *flags)
 {
-  const char escape = '\\';
   int n;
 
   for (n = 0; *s; ++s)
     {
+      const int c = cls (syntax, *s);
+
       /* A backslash followed by newline is replaced with a space and thus
          serves as a separator. Therefore, any newline, escaped or not is a
          separator.  */
-      if (*s == '\n')
+      if (c & TC_NEWLINE)
         {
           s -= n % 2;
           break;
         }
-      if (*s == escape)
+      if (c & TC_ESCAPE)
         {
+          if (!(cls (syntax, s[1]) & TC_NEWLINE))
+            *flags |= TOKEN_QUOTED;
           ++n;
           continue;
         }
-      if ((n % 2) == 0 && strchr (quotes_and_separators, (unsigned char) *s))
+      if ((n % 2) == 0 && (c & stop))
         break;
       n = 0;
     }
@@ -403,31 +1210,32 @@ skip_until_separator (const char *s)
   return s;
 }
 
-/* Return the index of the first character in 's' that is present in 'reject'
-   and not escaped with a backslash.
-   If backslash itself is present in 'reject', then nothing can be escaped,
-   because lookup returns the index of that very backslash and strecspn behaves
-   as strcspn.  */
+/* Return the index of the first character in 's' whose class in 'cls' is
+   present in 'reject' and which is not escaped with a character whose class is
+   'escape'.
+   If 'escape' itself is present in 'reject', then nothing can be escaped,
+   because lookup returns the index of that very escape character and strecspn
+   behaves as strcspn.  */
 static size_t
-strecspn (const char *s, const char *reject)
+strecspn (const char *s, const unsigned char *cls, int reject, int escape)
 {
   size_t result;
   int n = 0;
-  const char escape = '\\';
-  const char *escape_rejected = strchr (reject, (unsigned char) escape);
 
   for (result = 0; *s; ++s, ++result)
     {
-      if (*s == escape)
+      const int c = cls[(unsigned char) *s];
+
+      if (c & escape)
         {
           ++n;
-          if (escape_rejected)
+          if (reject & escape)
             break;
           else
             continue;
         }
 
-      if ((n % 2) == 0 && strchr (reject, (unsigned char) *s))
+      if ((n % 2) == 0 && (c & reject))
         break;
 
       n = 0;
@@ -438,30 +1246,26 @@ strecspn (const char *s, const char *reject)
 
 /* Same as strecspn within the first 'slen' characters of 's'.  */
 static size_t
-memecspn (const char *s, const char *reject, size_t slen)
+memecspn (const char *s, const unsigned char *cls, int reject, int escape,
+          size_t slen)
 {
   size_t result;
   int n = 0;
-  const char escape = '\\';
-  /* memchr along with 'rlen', rather than strchr, is used to ensure
-     that a \0 in '[s, s+slen)' does not match the null terminator in 'reject'.
-   */
-  size_t rlen = strlen (reject);
-  const char *escape_rejected =
-                         (char*) memchr (reject, (unsigned char) escape, rlen);
 
   for (result = 0; slen && *s; ++s, ++result, --slen)
     {
-      if (*s == escape)
+      const int c = cls[(unsigned char) *s];
+
+      if (c & escape)
         {
           ++n;
-          if (escape_rejected)
+          if (reject & escape)
             break;
           else
             continue;
         }
 
-      if ((n % 2) == 0 && memchr (reject, (unsigned char) *s, rlen))
+      if ((n % 2) == 0 && (c & reject))
         break;
 
       n = 0;
@@ -475,7 +1279,8 @@ memecspn (const char *s, const char *reject, size_t slen)
    Return the address immediately after the newly inserted space.
    Store the new end of the substring in '*endp'.  */
 static char *
-collapse_escaped_newlines (char *s, char *beg, const char **endp)
+collapse_escaped_newlines (char *s, char *beg, const char **endp,
+                           const struct token_syntax *syntax)
 {
   char *p;
   const char *end = *endp;
@@ -483,24 +1288,24 @@ collapse_escaped_newlines (char *s, char *beg, const char **endp)
   assert (beg < end);
   assert (beg <= s);
   assert (s < end);
-  assert (*s == '\\');
-  assert (s[1] == '\n');
+  assert (cls (syntax, *s) & TC_ESCAPE);
+  assert (cls (syntax, s[1]) & TC_NEWLINE);
 
   /* Convert all consecutive backslash-newline pairs along with
      surrounding space to a single space.  */
 
-  /* Walk back optional leading space.  */
-  for (p = s - 1; beg < p && (*p == '\t' || *p == ' '); --p)
+  /* Walk back optional leading space.
+     Do not step before 'beg', which can be the beginning of the buffer.  */
+  for (p = s; beg + 1 < p && (p[-1] == '\t' || p[-1] == ' '); --p)
     ;
-  ++p;
 
   /* Walk forward optional trailing space along with more
      backslash-newline pairs.  */
-  while (s < end && ((*s == '\t' || *s == ' ') || (*s == '\\' && s[1] == '\n')))
+  while (s < end && ((*s == '\t' || *s == ' ') || escaped_newline (s, syntax)))
     {
       for (; s < end && (*s == '\t' || *s == ' '); ++s)
         ;
-      for (; s < end && (*s == '\\' && s[1] == '\n'); s += 2)
+      for (; s < end && escaped_newline (s, syntax); s += 2)
         ;
     }
 
@@ -516,6 +1321,54 @@ collapse_escaped_newlines (char *s, char *beg, const char **endp)
   return p;
 }
 
+/* Return the state of the tokenizer after a character of class 'c' is read
+   in state 'state'.
+   These transitions follow next_token and skip_separators.  A transition to
+   TS_SEP from a state other than TS_SEP and TS_SEP_ESC ends a token.  */
+static int
+next_state (int state, int c)
+{
+  switch (state)
+    {
+    case TS_SEP:
+      if (c & TC_SEP)
+        return TS_SEP;
+      /* Fall through */
+    case TS_WORD:
+      if (c & TC_ESCAPE)
+        return state == TS_SEP ? TS_SEP_ESC : TS_WORD_ESC;
+      if (c & TC_SQUOTE)
+        return TS_SQUOTE;
+      if (c & TC_DQUOTE)
+        return TS_DQUOTE;
+      return c & TC_SEP ? TS_SEP : TS_WORD;
+    case TS_SEP_ESC:
+      /* A backslash-newline pair between tokens is skipped.  Any other
+         character is escaped by the backslash that begins a token.  */
+      return c & TC_NEWLINE ? TS_SEP : TS_WORD;
+    case TS_WORD_ESC:
+      /* An escaped newline serves as a separator.  */
+      return c & TC_NEWLINE ? TS_SEP : TS_WORD;
+    case TS_SQUOTE:
+      return c & TC_SQUOTE ? TS_WORD : TS_SQUOTE;
+    case TS_DQUOTE:
+      if (c & TC_ESCAPE)
+        return TS_DQUOTE_ESC;
+      return c & TC_DQUOTE ? TS_WORD : TS_DQUOTE;
+    case TS_DQUOTE_ESC:
+      return TS_DQUOTE;
+    }
+  assert (0);
+  return TS_SEP;
+}
+
+/* Return 1 if 'state' is a state inside a token.  */
+static int
+in_token (int state)
+{
+  return state != TS_SEP && state != TS_SEP_ESC;
+}
+
 /* Copyright (c) 2023 Dmitry Goncharov
  * dgoncharov@users.sf.net.
  *
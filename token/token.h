@@ -63,6 +63,175 @@ extern "C" {
      Return the beginning of the first token.  */
 char *next_dequoted_token (char **s, size_t *tokenlen, int *status);
 
+/* The character classes of a tokenizer.
+
+   By default, a space, tab or newline serves as a token separator, a single
+   or double quote serves as a quote and a backslash serves as an escape
+   character.  A token_syntax specifies other characters, e.g. a comma or a
+   semicolon as a token separator, or no single quote.
+   'cls' maps each character to its class.  The table is built once by
+   token_syntax_init and then passed to the tokenizing functions, which look
+   up the class of each character in the table.  */
+struct token_syntax
+{
+  unsigned char cls[256];
+};
+
+/* Initialize 'syntax'.
+   Each character of 'separators' serves as a token separator.  If
+   'separators' is null, a space, tab and newline serve as token separators.
+   An escaped newline is treated as such only when a newline is a token
+   separator.
+   'squote' serves as a single quote, 'dquote' serves as a double quote and
+   'escape' serves as an escape character.  If any of 'squote', 'dquote' or
+   'escape' is 0, then no character serves as such.
+   If a character is given more than one role, the last one of separator,
+   single quote, double quote and escape character wins.  */
+void token_syntax_init (struct token_syntax *syntax, const char *separators,
+                        char squote, char dquote, char escape);
+
+/* Same as next_dequoted_token with the character classes of 'syntax'.
+   If 'syntax' is null, the default character classes are used.  */
+char *next_dequoted_token_syntax (char **s, size_t *tokenlen, int *status,
+                                  const struct token_syntax *syntax);
+
+/* The bits, which next_dequoted_token_flags sets to describe a token.  */
+enum
+{
+  TOKEN_DOLLAR = 1,     /* A $, which is neither escaped nor single quoted.  */
+  TOKEN_BACKTICK = 2,   /* A `, which is neither escaped nor single quoted.  */
+  TOKEN_GLOB = 4,       /* A *, ? or [, which is not escaped or quoted.  */
+  TOKEN_QUOTED = 8      /* A quote or an escape character.  */
+};
+
+/* Same as next_dequoted_token_syntax.  In addition, if 'flags' is not null,
+   set '*flags' to the TOKEN_* bits which describe the token.
+   The bits are found in the same scan, which finds the token.  A token, which
+   has none of the bits set, is returned as is and needs neither variable
+   expansion, nor command substitution, nor pathname expansion.
+   Like in a shell, double quotes do not prevent $ or ` from being expanded.
+   If no token is found, set '*flags' to 0.  */
+char *next_dequoted_token_flags (char **s, size_t *tokenlen, int *status,
+                                 int *flags,
+                                 const struct token_syntax *syntax);
+
+/* The state of a tokenizer, which reads input in chunks.
+
+   'buf' holds the unfinished token, if any, followed by the input that was
+   fed, but has not been tokenized yet.  Tokens are dequoted in place in 'buf'.
+   When a chunk ends in the middle of a token, 'state' records whether the
+   chunk ended inside single quotes, inside double quotes, or after an odd
+   number of backslashes, and 'scanned' records how much of the unfinished
+   token has been scanned.  Once the next chunk arrives, tokenization resumes
+   from 'scanned', rather than from the beginning of the token.
+   The tokens that have been returned are discarded when the next chunk is fed.
+   Therefore, the memory held by 'buf' is bounded by the length of the longest
+   token plus the length of the longest chunk.  */
+struct token_stream
+{
+  char *buf;
+  size_t len;       /* The number of characters in 'buf'.  */
+  size_t size;      /* The size of 'buf'.  */
+  size_t pos;       /* The beginning of the unfinished token.  */
+  size_t scanned;   /* The first character not scanned yet.  */
+  int state;        /* The state of the tokenizer at 'scanned'.  */
+  int eof;          /* Set when the end of input has been fed.  */
+  const struct token_syntax *syntax;  /* The character classes, or null for
+                                         the default ones.  */
+};
+
+/* Initialize 'ts' with the default character classes.  To use other
+   character classes, set 'ts->syntax' after token_stream_init.  */
+void token_stream_init (struct token_stream *ts);
+
+/* Release the memory held by 'ts'.  */
+void token_stream_free (struct token_stream *ts);
+
+/* Append the first 'len' characters of 'chunk' to the input of 'ts'.
+   A 'len' of 0 marks the end of input.
+   'chunk' shall not contain null characters.
+   The tokens previously returned by token_stream_next are no longer valid
+   once this function is called.
+   Return 0 on success.
+   Return -1 and set errno if memory cannot be allocated.  */
+int token_stream_feed (struct token_stream *ts, const char *chunk, size_t len);
+
+/* Find, validate and dequote the next token in the input fed to 'ts'.
+
+   The tokenizing and dequoting rules are those of next_dequoted_token.
+
+   If the input fed so far does not have a complete token and the end of input
+   has not been fed,
+     Keep '*status' intact.
+     Set '*tokenlen' to 0.
+     Return 0.
+   The caller is expected to feed the next chunk and call token_stream_next
+   again.
+
+   If the end of input has been fed and no token is left,
+     Keep '*status' intact.
+     Set '*tokenlen' to 0.
+     Return 0.
+
+   Otherwise, if the end of input has been fed and a not escaped opening quote
+   is present in the last token, but a corresponding closing quote is missing,
+   then,
+     Set '*status' to 1.
+     Set '*tokenlen' to the length of the last token.
+     Return the beginning of the last token.
+
+   Otherwise,
+     Keep '*status' intact.
+     Set '*tokenlen' to the length of the dequoted token.
+     Return the beginning of the dequoted null terminated token.  */
+char *token_stream_next (struct token_stream *ts, size_t *tokenlen,
+                         int *status);
+
+/* Find, validate and dequote all tokens in 's' using up to 'nthreads'
+   threads.
+
+   The tokenizing and dequoting rules are those of next_dequoted_token with the
+   character classes of 'syntax'.  If 'syntax' is null, the default character
+   classes are used.
+   The result is the same as that of the following loop.
+
+   while ((t = next_dequoted_token_syntax (&s, &tokenlens[n], status, syntax)))
+     tokens[n++] = t;
+
+   The input is split in chunks, one or more per thread.  Each thread computes
+   the state of the tokenizer at the end of its chunk for every possible state
+   at the beginning of the chunk.  These per chunk transitions are then
+   chained to find the actual state at the beginning of each chunk, which lets
+   the threads find and dequote the tokens of their chunks concurrently.
+
+   'tokens' and 'tokenlens' shall have room for 1 + strlen (s) / 2 elements.
+   Store the address of each token in 'tokens' and the length of each
+   token in 'tokenlens'.
+   Store the number of tokens in '*ntokens'.
+   If a not escaped opening quote is present in the last token, but a
+   corresponding closing quote is missing, set '*status' to 1.  Otherwise, keep
+   '*status' intact.
+   Return 0 on success.
+   Return -1 and set errno if memory cannot be allocated.  */
+int parallel_dequoted_tokens (char *s, char **tokens, size_t *tokenlens,
+                              size_t *ntokens, int *status, int nthreads,
+                              const struct token_syntax *syntax);
+
+/* Quote the first 'srclen' characters of 'src' for next_dequoted_token.
+
+   Store to 'dst' the shortest string, which next_dequoted_token returns
+   unchanged as one token equal to '[src, src + srclen)'.  Each part of the
+   string is either left unquoted with backslashes escaping separators, quotes
+   and backslashes, or put in single quotes, or put in double quotes.  A
+   newline cannot be escaped and is always put in quotes.  An empty 'src' is
+   quoted as ''.
+   'src' shall not contain null characters.  'dst' shall have room for
+   2 * srclen + 3 characters and shall not overlap 'src'.
+   A string without separators, quotes and backslashes is copied as is.
+   Null terminate 'dst'.
+   Return the length of the string stored to 'dst'.  */
+size_t quote_token (char *dst, const char *src, size_t srclen);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,8 +7,23 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdarg.h>
+#ifdef __linux__
+#include <link.h>
+#endif
 
 static const char quotes[] = "'\"";
+/* Inputs which are tokenized by parts.  */
+static const char *samples[] = {
+  "", " ", "\\", "\\\n", " \\\n ", "hello", "hello world",
+  "  one 'two three' four  ", "\"five six\nseven\"",
+  "eight\\ nine", "ten\\\\ eleven\\\n\\\n\\\ntwelve",
+  "hello\\\\\\ world\\\\", "a\\'b\\\"c", "'' \"\"",
+  "hello'world'of'many'tokens", "\"a\\\\\\\"b\" c",
+  "\"hello, \t \\\n \t \\\n\t \t\\\n  \t\tworld\"",
+  "'hello,\\\nworld' x", "one 'two", "one \"two\\\"", "x\\",
+  "\\\\\n\\\n", "-w -E 'use warnings FATAL => \"all\";' -E",
+  " \\x \\", "a \\\n\\", 0
+};
 static const char *dquote_and_separators = quotes_and_separators + 1;
 static int test (long, int, char *[]);
 static void test_memecspn (int, const char *, const char *, size_t);
@@ -29,6 +44,19 @@ static void test_next_dequoted_token_ws_impl (int, const char *, const char *,
                                               va_list, char);
 static void test_next_dequoted_token_impl (int, const char *, const char *,
                                            va_list, char, char);
+static void test_token_stream (int, const char *);
+static void test_token_stream_impl (int, const char *, size_t, size_t,
+                                    const struct token_syntax *);
+static void test_parallel_dequoted_tokens (int, const char *);
+static void test_parallel_dequoted_tokens_impl (int, const char *, int,
+                                                size_t,
+                                                const struct token_syntax *);
+static void test_syntax (int, const struct token_syntax *, const char *,
+                         const char *, ...);
+static int reject_classes (const char *, unsigned char *);
+static void test_flags (int, const char *, ...);
+static void test_quote_token (int, const char *, size_t, const char *);
+static int count_probes (const char *, int);
 static char *strdup_ (const char *s);
 static char *subchr (char *input, char x, char y);
 static char *swapchr (char *input, char x, char y);
@@ -66,6 +94,12 @@ memecspn
 strecspn
 next_token
 next_dequoted_token
+token_stream_next
+parallel_dequoted_tokens
+next_dequoted_token_syntax
+next_dequoted_token_flags
+quote_token
+usdt probes
 
 These characters have special powers.
 backslash, space, newline, single quote, double quote.
@@ -1847,6 +1881,245 @@ test (long n, int argc, char *argv[])
         }
         /* Fall through */
 
+      /* Input split in chunks.  */
+      case __LINE__:
+        {
+          const char **in;
+          for (in = samples; *in; ++in)
+            test_token_stream (__LINE__, *in);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* A token is longer than a chunk.  */
+      case __LINE__:
+        {
+          int k;
+          char *input = (char*) malloc (1024 * 65);
+          ASSERT (input, "cannot allocate 65K on heap\n");
+          for (k = 0; k < 1024 * 65; ++k)
+            input[k] = 'a' + k % 9;
+          input[0] = '"';
+          input[1024 * 32] = '"';
+          input[1024 * 33] = ' ';
+          input[1024 * 65 - 1] = '\0';
+          test_token_stream_impl (__LINE__, input, 7, 1000, 0);
+          test_token_stream_impl (__LINE__, input, 1024 * 32, 1024 * 32, 0);
+          free (input);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* Input tokenized by multiple threads.  */
+      case __LINE__:
+        {
+          const char **in;
+          for (in = samples; *in; ++in)
+            test_parallel_dequoted_tokens (__LINE__, *in);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* Random input tokenized by multiple threads.  */
+      case __LINE__:
+        {
+          const char alphabet[] = "ab  '\"\\\\\n\t";
+          char input[4096];
+          int k, j;
+          srand (1);
+          for (k = 0; k < 64; ++k)
+            {
+              for (j = 0; j < (int) sizeof input - 1; ++j)
+                input[j] = alphabet[rand () % (sizeof alphabet - 1)];
+              input[j] = '\0';
+              test_parallel_dequoted_tokens_impl (__LINE__, input, 4, 2, 0);
+              test_parallel_dequoted_tokens_impl (__LINE__, input, 3, 64, 0);
+              test_parallel_dequoted_tokens_impl (__LINE__, input, 8, 1000,
+                                                  0);
+              test_token_stream_impl (__LINE__, input, 5, 300, 0);
+            }
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* A token is longer than a chunk.  */
+      case __LINE__:
+        {
+          int k;
+          char *input = (char*) malloc (1024 * 65);
+          char **tokens = (char**) malloc ((1 + 1024 * 65 / 2) * sizeof *tokens);
+          size_t *tokenlens =
+                (size_t*) malloc ((1 + 1024 * 65 / 2) * sizeof *tokenlens);
+          size_t ntokens = 0;
+          int r, status = 0;
+          ASSERT (input, "cannot allocate 65K on heap\n");
+          for (k = 0; k < 1024 * 65; ++k)
+            input[k] = 'a' + k % 9;
+          input[0] = '"';
+          input[1024 * 64] = '"';
+          input[1024 * 64 + 1] = ' ';
+          input[1024 * 65 - 1] = '\0';
+          test_parallel_dequoted_tokens_impl (__LINE__, input, 4, 1024, 0);
+          r = parallel_dequoted_tokens (input, tokens, tokenlens, &ntokens,
+                                        &status, 4, 0);
+          ASSERT (r == 0, "r = %d, line = %d\n", r, __LINE__);
+          ASSERT (ntokens == 2, "ntokens = %lu, line = %d\n", ntokens,
+                  __LINE__);
+          ASSERT (tokenlens[0] == 1024 * 64 - 1,
+                  "tokenlens[0] = %lu, line = %d\n", tokenlens[0], __LINE__);
+          ASSERT (tokens[0] == input, "line = %d\n", __LINE__);
+          ASSERT (status == 0, "status = %d, line = %d\n", status, __LINE__);
+          free (tokenlens);
+          free (tokens);
+          free (input);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* Other character classes.  */
+      case __LINE__:
+        {
+          struct token_syntax syntax;
+          token_syntax_init (&syntax, 0, '\'', '"', '\\');
+          ASSERT (memcmp (&syntax, &default_syntax, sizeof syntax) == 0,
+                  "line = %d\n", __LINE__);
+
+          /* A comma serves as a separator.  */
+          token_syntax_init (&syntax, ",", '\'', '"', '\\');
+          test_syntax (__LINE__, &syntax, "a,b c,,'d,e',\"f\\\"g\",h\\,i,",
+                       "a", "b c", "d,e", "f\"g", "h,i", 0);
+          /* A newline is not a separator.  */
+          test_syntax (__LINE__, &syntax, "a\\\nb,\"c\\\nd\"",
+                       "a\nb", "c\\\nd", 0);
+          test_syntax (__LINE__, &syntax, "a,'b", "a", "'b", 0);
+
+          /* A semicolon and a newline serve as separators.  No single
+             quotes.  */
+          token_syntax_init (&syntax, ";\n", 0, '"', '\\');
+          test_syntax (__LINE__, &syntax, "it's;\"a;b\";c\\\n;d\ne",
+                       "it's", "a;b", "c", "d", "e", 0);
+          test_syntax (__LINE__, &syntax, "\"a\\\n  b\" c", "a b c", 0);
+
+          /* No escape character.  */
+          token_syntax_init (&syntax, " ", '\'', '"', 0);
+          test_syntax (__LINE__, &syntax, "a\\ \"b\\ c\\\" d", "a\\",
+                       "b\\ c\\", "d", 0);
+
+          /* Other quotes and escape character.  */
+          token_syntax_init (&syntax, " ", '`', '|', '%');
+          test_syntax (__LINE__, &syntax, "`a b` |c%| d| 'e\"f\\ %%",
+                       "a b", "c| d", "'e\"f\\", "%", 0);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* Token flags.  */
+      case __LINE__:
+        {
+          const int d = TOKEN_DOLLAR, b = TOKEN_BACKTICK, g = TOKEN_GLOB;
+          const int q = TOKEN_QUOTED;
+          test_flags (__LINE__, "", -1);
+          test_flags (__LINE__, "hello world", 0, 0, -1);
+          test_flags (__LINE__, "$x ${y} a$", d, d, d, -1);
+          test_flags (__LINE__, "`date` a`b", b, b, -1);
+          test_flags (__LINE__, "*.c a? [ab]", g, g, g, -1);
+          test_flags (__LINE__, "'$x' '`*'", q, q, -1);
+          test_flags (__LINE__, "\"$x\" \"`a`\" \"*\"", q | d, q | b, q, -1);
+          test_flags (__LINE__, "\\$x \\` \\* \"\\$\"", q, q, q, q, -1);
+          test_flags (__LINE__, "\\\\$x", q | d, -1);
+          test_flags (__LINE__, "a\\\nb \\\n c", 0, 0, 0, -1);
+          test_flags (__LINE__, "'a'$b\"c\"*", q | d | g, -1);
+          test_flags (__LINE__, "a\\ b '' c", q, q, 0, -1);
+          test_flags (__LINE__, "x 'a$", 0, q, -1);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* Quoting.  The expected quoting is one of the shortest.  */
+      case __LINE__:
+        test_quote_token (__LINE__, "hello", 5, "hello");
+        test_quote_token (__LINE__, "", 0, "''");
+        test_quote_token (__LINE__, "a b", 3, "a\\ b");
+        test_quote_token (__LINE__, "it's", 4, "it\\'s");
+        test_quote_token (__LINE__, "\n", 1, "'\n'");
+        test_quote_token (__LINE__, "a\nb", 3, "'a\nb'");
+        test_quote_token (__LINE__, "a  b c", 6, "'a  b c'");
+        test_quote_token (__LINE__, "\\", 1, "\\\\");
+        test_quote_token (__LINE__, "'\n'", 3, "\"'\n'\"");
+        test_quote_token (__LINE__, "x\\\n", 3, "'x\\\n'");
+        test_quote_token (__LINE__, "\"'", 2, "\\\"\\'");
+        test_quote_token (__LINE__, "''''", 4, "\"''''\"");
+        test_quote_token (__LINE__, "'\\\\\n", 4, "\\''\\\\\n'");
+        test_quote_token (__LINE__, "a\\\n \\\n", 6, "'a\\\n \\\n'");
+        test_quote_token (__LINE__, "hello, world\n", 13, "'hello, world\n'");
+        test_quote_token (__LINE__, "/usr/lib/x86_64-linux-gnu", 25,
+                          "/usr/lib/x86_64-linux-gnu");
+        test_quote_token (__LINE__, "/usr/lib/x86_64-linux gnu", 25,
+                          "/usr/lib/x86_64-linux\\ gnu");
+        if (n)
+          break;
+        /* Fall through */
+
+      /* Random strings are quoted and dequoted back.  */
+      case __LINE__:
+        {
+          const char alphabet[] = "ab '\"\\\n\t$";
+          char input[24];
+          int k, j, len;
+          srand (2);
+          for (k = 0; k < 20000; ++k)
+            {
+              len = rand () % (int) sizeof input;
+              for (j = 0; j < len; ++j)
+                input[j] = alphabet[rand () % (sizeof alphabet - 1)];
+              test_quote_token (__LINE__, input, len, 0);
+            }
+          if (n)
+            break;
+        }
+        /* Fall through */
+
+      /* The usdt probes of next_dequoted_token are present with PROBES=1
+         and absent otherwise.  */
+      case __LINE__:
+        {
+#if defined TOKEN_PROBES && defined __linux__
+          const int expected = 1;
+#else
+          const int expected = 0;
+#endif
+          char input[] = "a 'b";
+          char *s = input, *t;
+          size_t len;
+          int status = 0;
+          long count;
+
+          printf ("token test %d\n", __LINE__);
+          count = count_probes ("next_dequoted_token", 1);
+          ASSERT ((count > 0) == expected, "count = %ld, line = %d\n", count,
+                  __LINE__);
+          count = count_probes ("next_dequoted_token_failure", 3);
+          ASSERT ((count > 0) == expected, "count = %ld, line = %d\n", count,
+                  __LINE__);
+
+          /* The probes do not change the result.  */
+          t = next_dequoted_token (&s, &len, &status);
+          ASSERT (t && strcmp (t, "a") == 0 && status == 0,
+                  "line = %d\n", __LINE__);
+          t = next_dequoted_token (&s, &len, &status);
+          ASSERT (t && len == 2 && status == 1, "line = %d\n", __LINE__);
+          if (n)
+            break;
+        }
+        /* Fall through */
+
       default:
         retcode = -1;
         break;
@@ -1865,9 +2138,11 @@ test_memecspn_impl (int line, const char *s, size_t slen, const char *reject,
                     size_t expected)
 {
   size_t r;
+  unsigned char cls[256];
+  const int rej = reject_classes (reject, cls);
 
   printf ("token test %d\n", line);
-  r = memecspn (s, reject, slen);
+  r = memecspn (s, cls, rej, 2, slen);
   ASSERT (r == expected,
           "input = \"%s\", reject = \"%s\", expected = %lu, result = %lu, "
           "line = %d\n",
@@ -1878,15 +2153,32 @@ static void
 test_strecspn (int line, const char *s, const char *reject, size_t expected)
 {
   size_t r;
+  unsigned char cls[256];
+  const int rej = reject_classes (reject, cls);
 
   printf ("token test %d\n", line);
-  r = strecspn (s, reject);
+  r = strecspn (s, cls, rej, 2);
   ASSERT (r == expected,
           "input = \"%s\", reject = \"%s\", expected = %lu, result = %lu, "
           "line = %d\n",
           s, reject, expected, r, line);
 }
 
+/* Store to 'cls' a class table, where each character of 'reject' has class 1
+   and a backslash has class 2.
+   Return the classes of the characters of 'reject'.  */
+static int
+reject_classes (const char *reject, unsigned char *cls)
+{
+  const char *r;
+
+  memset (cls, 0, 256);
+  for (r = reject; *r; ++r)
+    cls[(unsigned char) *r] = 1;
+  cls['\\'] = 2;
+  return strchr (reject, '\\') ? 3 : 1;
+}
+
 /* Test next_token with the specified 'input', as well as modified
    'input' where each single quote is replaced with a double quote and each
    space is replaced with a tab and a newline.  */
@@ -1963,7 +2255,7 @@ test_next_token_impl (int line, const char *input, const char *expected,
   do
     {
       elen = expected ? strlen (expected) : 0;
-      t = next_token (&s, &tlen, &status);
+      t = next_token (&s, &tlen, &status, 0, &default_syntax);
       ASSERT (tlen == elen,
               "strlen (expected) = %lu, tlen = %lu, line = %d\n",
               elen, tlen, line);
@@ -1992,7 +2284,7 @@ test_next_token_impl (int line, const char *input, const char *expected,
     /* After went through all expected tokens, next next_token call
        should return 0.  This tests that all calls of test_next_token pass all
        expected tokens.  */
-    t = next_token (&s, &tlen, &status);
+    t = next_token (&s, &tlen, &status, 0, &default_syntax);
     ASSERT (t == 0,
             "input = '%s', result = '%.*s', line = %d\n",
             input, (int) tlen, t, line);
@@ -2123,6 +2415,324 @@ test_next_dequoted_token_impl (int line, const char *input,
   free (beg);
 }
 
+/* Test token_stream_next with the specified 'input' split in two chunks at
+   every position, as well as split in chunks of one character.  */
+static void
+test_token_stream (int line, const char *input)
+{
+  size_t k, len = strlen (input);
+
+  for (k = 0; k <= len; ++k)
+    test_token_stream_impl (line, input, k, len, 0);
+  test_token_stream_impl (line, input, 1, 1, 0);
+}
+
+/* Feed the specified 'input' to token_stream_next in chunks of 'chunklen'
+   characters, except the first chunk, which is 'first' characters long.
+   Test that token_stream_next produces the same tokens and status as
+   next_dequoted_token_syntax does given the whole 'input'.  */
+static void
+test_token_stream_impl (int line, const char *input, size_t first,
+                        size_t chunklen, const struct token_syntax *syntax)
+{
+  struct token_stream ts;
+  char *beg, *s, *t, *u;
+  size_t n, tlen, ulen, off, len;
+  int r, status = 0, ustatus = 0;
+
+  printf ("token test %d\n", line);
+
+  beg = s = strdup_ (input);
+  len = strlen (input);
+  token_stream_init (&ts);
+  ts.syntax = syntax;
+  for (off = 0, n = first; !ts.eof; off += n, n = chunklen)
+    {
+      if (n > len - off)
+        n = len - off;
+      /* An empty chunk marks the end of input.  */
+      if (n > 0 || off == len)
+        {
+          r = token_stream_feed (&ts, input + off, n);
+          ASSERT (r == 0, "r = %d, line = %d\n", r, line);
+        }
+      while ((u = token_stream_next (&ts, &ulen, &ustatus)))
+        {
+          t = next_dequoted_token_syntax (&s, &tlen, &status, syntax);
+          ASSERT (t, "input = '%s', result = '%.*s', first = %lu, line = %d\n",
+                  input, (int) ulen, u, first, line);
+          if (t == 0)
+            break;
+          ASSERT (ulen == tlen && memcmp (t, u, tlen) == 0,
+                  "input = '%s', expected = '%s', result = '%s', "
+                  "first = %lu, line = %d\n",
+                  input, t, u, first, line);
+        }
+    }
+  t = next_dequoted_token_syntax (&s, &tlen, &status, syntax);
+  ASSERT (t == 0, "input = '%s', expected = '%.*s', first = %lu, line = %d\n",
+          input, (int) tlen, t, first, line);
+  ASSERT (ustatus == status,
+          "input = '%s', status = %d, expected = %d, line = %d\n",
+          input, ustatus, status, line);
+  token_stream_free (&ts);
+  free (beg);
+}
+
+/* Test parallel_dequoted_tokens with the specified 'input' split in chunks
+   of various lengths and tokenized by various numbers of threads.  */
+static void
+test_parallel_dequoted_tokens (int line, const char *input)
+{
+  size_t chunklen, len = strlen (input);
+  int nthreads;
+
+  for (nthreads = 1; nthreads < 5; ++nthreads)
+    for (chunklen = 2; chunklen < len + 4; chunklen += 2)
+      test_parallel_dequoted_tokens_impl (line, input, nthreads, chunklen, 0);
+}
+
+/* Test that 'nthreads' threads, which tokenize the specified 'input' split in
+   chunks of 'chunklen' characters, produce the same tokens and status as
+   next_dequoted_token_syntax does.  */
+static void
+test_parallel_dequoted_tokens_impl (int line, const char *input, int nthreads,
+                                    size_t chunklen,
+                                    const struct token_syntax *syntax)
+{
+  char *beg, *s, *t, *in;
+  char **tokens;
+  size_t *tokenlens;
+  size_t k, tlen, ntokens, len = strlen (input);
+  int r, status = 0, pstatus = 0;
+
+  printf ("token test %d\n", line);
+
+  in = strdup_ (input);
+  tokens = (char**) malloc ((1 + len / 2) * sizeof *tokens);
+  tokenlens = (size_t*) malloc ((1 + len / 2) * sizeof *tokenlens);
+  assert (tokens && tokenlens);
+  r = dequoted_tokens_impl (in, len, tokens, tokenlens, &ntokens, &pstatus,
+                            nthreads, chunklen,
+                            syntax ? syntax : &default_syntax);
+  ASSERT (r == 0, "r = %d, line = %d\n", r, line);
+
+  beg = s = strdup_ (input);
+  for (k = 0; (t = next_dequoted_token_syntax (&s, &tlen, &status, syntax));
+       ++k)
+    {
+      ASSERT (k < ntokens,
+              "input = '%s', ntokens = %lu, chunklen = %lu, line = %d\n",
+              input, ntokens, chunklen, line);
+      if (k >= ntokens)
+        break;
+      ASSERT (tokenlens[k] == tlen && memcmp (t, tokens[k], tlen) == 0,
+              "input = '%s', expected = '%s', result = '%s', "
+              "chunklen = %lu, line = %d\n",
+              input, t, tokens[k], chunklen, line);
+    }
+  ASSERT (k == ntokens,
+          "input = '%s', ntokens = %lu, expected = %lu, chunklen = %lu, "
+          "line = %d\n",
+          input, ntokens, k, chunklen, line);
+  ASSERT (pstatus == status,
+          "input = '%s', status = %d, expected = %d, line = %d\n",
+          input, pstatus, status, line);
+  free (beg);
+  free (tokenlens);
+  free (tokens);
+  free (in);
+}
+
+/* Test that next_dequoted_token_syntax, token_stream_next and
+   parallel_dequoted_tokens produce the 0 terminated list of 'expected' tokens
+   given the specified 'input' and character classes 'syntax'.  */
+static void
+test_syntax (int line, const struct token_syntax *syntax, const char *input,
+             const char *expected, ...)
+{
+  char *beg, *s, *t;
+  size_t k, tlen, len = strlen (input);
+  int status = 0;
+  va_list ap;
+
+  printf ("token test %d\n", line);
+
+  beg = s = strdup_ (input);
+  va_start (ap, expected);
+  for (; expected; expected = va_arg (ap, const char *))
+    {
+      t = next_dequoted_token_syntax (&s, &tlen, &status, syntax);
+      ASSERT (t && tlen == strlen (expected) && memcmp (t, expected, tlen) == 0,
+              "input = '%s', expected = '%s', result = '%.*s', line = %d\n",
+              input, expected, (int) tlen, t ? t : "", line);
+      if (t == 0)
+        break;
+    }
+  va_end (ap);
+  t = next_dequoted_token_syntax (&s, &tlen, &status, syntax);
+  ASSERT (t == 0, "input = '%s', result = '%.*s', line = %d\n",
+          input, (int) tlen, t, line);
+  free (beg);
+
+  for (k = 0; k <= len; ++k)
+    test_token_stream_impl (line, input, k, len, syntax);
+  for (k = 2; k < len + 4; k += 2)
+    test_parallel_dequoted_tokens_impl (line, input, 3, k, syntax);
+}
+
+/* Test that next_dequoted_token_flags produces the same tokens as
+   next_dequoted_token given the specified 'input' and sets the -1 terminated
+   list of expected flags.  */
+static void
+test_flags (int line, const char *input, ...)
+{
+  char *beg, *s, *t, *ubeg, *u, *v;
+  size_t tlen, ulen;
+  int k, flags, expected, status = 0, ustatus = 0;
+  va_list ap;
+
+  printf ("token test %d\n", line);
+
+  beg = s = strdup_ (input);
+  ubeg = u = strdup_ (input);
+  va_start (ap, input);
+  for (k = 0; (t = next_dequoted_token_flags (&s, &tlen, &status, &flags, 0));
+       ++k)
+    {
+      v = next_dequoted_token (&u, &ulen, &ustatus);
+      ASSERT (v && ulen == tlen && memcmp (t, v, tlen) == 0,
+              "input = '%s', expected = '%s', result = '%s', line = %d\n",
+              input, v ? v : "", t, line);
+      expected = va_arg (ap, int);
+      ASSERT (flags == expected,
+              "input = '%s', token = %d, flags = %d, expected = %d, "
+              "line = %d\n",
+              input, k, flags, expected, line);
+      if (expected == -1)
+        break;
+    }
+  if (t == 0)
+    {
+      ASSERT (flags == 0, "input = '%s', flags = %d, line = %d\n",
+              input, flags, line);
+      expected = va_arg (ap, int);
+      ASSERT (expected == -1, "input = '%s', ntokens = %d, line = %d\n",
+              input, k, line);
+    }
+  va_end (ap);
+  ASSERT (status == ustatus, "input = '%s', status = %d, line = %d\n",
+          input, status, line);
+  free (ubeg);
+  free (beg);
+}
+
+/* Test that quote_token quotes the first 'len' characters of 'input' to
+   'expected' and that next_dequoted_token returns 'input' back from the
+   quoted string.  If 'expected' is null, only test that the result is no
+   longer than the result of putting 'input' in double quotes.  */
+static void
+test_quote_token (int line, const char *input, size_t len,
+                  const char *expected)
+{
+  char *dst, *s, *t;
+  size_t dlen, tlen;
+  int status = 0;
+
+  printf ("token test %d\n", line);
+
+  /* Allocate exactly as much as quote_token needs to let asan catch an
+     overflow.  */
+  dst = (char*) malloc (2 * len + 3);
+  assert (dst);
+  dlen = quote_token (dst, input, len);
+  ASSERT (dlen == strlen (dst), "dlen = %lu, line = %d\n", dlen, line);
+  if (expected)
+    ASSERT (dlen == strlen (expected),
+            "input = '%.*s', expected = '%s', result = '%s', line = %d\n",
+            (int) len, input, expected, dst, line);
+  else
+    ASSERT (dlen <= 2 * len + 2, "input = '%.*s', result = '%s', line = %d\n",
+            (int) len, input, dst, line);
+
+  s = dst;
+  t = next_dequoted_token (&s, &tlen, &status);
+  ASSERT (t && tlen == len && memcmp (t, input, len) == 0 && status == 0,
+          "input = '%.*s', result = '%s', line = %d\n",
+          (int) len, input, t ? t : "", line);
+  t = next_dequoted_token (&s, &tlen, &status);
+  ASSERT (t == 0, "input = '%.*s', result = '%s', line = %d\n",
+          (int) len, input, t, line);
+  free (dst);
+}
+
+/* Return the number of libtoken usdt probes called 'name', which have
+   'nargs' arguments, in section .note.stapsdt of this program.  */
+static int
+count_probes (const char *name, int nargs)
+{
+#ifdef __linux__
+  FILE *f;
+  long size;
+  char *elf, *p, *end;
+  const ElfW(Ehdr) *eh;
+  const ElfW(Shdr) *sh;
+  const char *names;
+  int k, n = 0;
+
+  f = fopen ("/proc/self/exe", "rb");
+  assert (f);
+  fseek (f, 0, SEEK_END);
+  size = ftell (f);
+  rewind (f);
+  elf = (char*) malloc (size);
+  assert (elf);
+  k = fread (elf, size, 1, f) == 1;
+  assert (k);
+  fclose (f);
+
+  eh = (const ElfW(Ehdr) *) elf;
+  sh = (const ElfW(Shdr) *) (elf + eh->e_shoff);
+  names = elf + sh[eh->e_shstrndx].sh_offset;
+  for (k = 0; k < eh->e_shnum; ++k)
+    {
+      if (strcmp (names + sh[k].sh_name, ".note.stapsdt"))
+        continue;
+      p = elf + sh[k].sh_offset;
+      end = p + sh[k].sh_size;
+      while (p < end)
+        {
+          const ElfW(Nhdr) *nh = (const ElfW(Nhdr) *) p;
+          const char *note = p + sizeof *nh;
+          const char *desc = note + ((nh->n_namesz + 3) & ~3u);
+          const char *provider, *probe, *args;
+          int a = 0;
+
+          p = (char*) desc + ((nh->n_descsz + 3) & ~3u);
+          if (nh->n_type != 3 || strcmp (note, "stapsdt"))
+            continue;
+          /* The probe address, the base address and the semaphore address
+             are followed by the provider, the name and the arguments.  */
+          provider = desc + 3 * sizeof (ElfW(Addr));
+          probe = provider + strlen (provider) + 1;
+          args = probe + strlen (probe) + 1;
+          if (strcmp (provider, "libtoken") || strcmp (probe, name))
+            continue;
+          for (; *args; ++args)
+            a += *args == '@';
+          ASSERT (a == nargs, "name = %s, a = %d\n", name, a);
+          ++n;
+        }
+    }
+  free (elf);
+  return n;
+#else
+  (void) name;
+  (void) nargs;
+  return 0;
+#endif
+}
+
 /* Duplicate a string and assert on success.  */
 static char *
 strdup_ (const char *s)